@@ -1,45 +1,358 @@
+#define MMAP_IMPLEMENTATION
+#define CACHE_IMPLEMENTATION
+#define STREAM_IMPLEMENTATION
+#define PARALLEL_IMPLEMENTATION
 #include "../nob.h"
 
-int main(int argc, char **argv) {
-	FILE *input = open_input_or_die(argc, argv);
-	
-	int state = 50;
+// Parse the unsigned distance that follows the direction letter
+static inline int parse_distance(const char *s, size_t len) {
+	int v = 0;
+	for (size_t i = 0; i < len && s[i] >= '0' && s[i] <= '9'; ++i) {
+		v = v * 10 + (s[i] - '0');
+	}
+	return v;
+}
+
+// --- Incremental tracker ---
+//
+// O(1) state for a live feed: push rotations as they arrive, checkpoint the
+// tracker to a file and later resume it against only the appended tail.
+
+typedef struct {
+	ll modulus;
+	ll state;
+	ll part1;
+	ll part2;
+	ll lines;
+} DialTracker;
+
+#define DIAL_CHECKPOINT_MAGIC "dial-checkpoint v1"
+
+static DialTracker dial_tracker_new(ll modulus) {
+	return (DialTracker){ .modulus = modulus, .state = modulus / 2 };
+}
+
+// Written with a literal modulus so the common dial gets constant divisions
+static inline void dial_push_mod(DialTracker *t, char dir, ll dist, ll m) {
+	ll q = dist / m, r = dist % m, s = t->state;
+
+	if (dir == 'R') {
+		ll up = s + r;
+		t->part2 += q + (up >= m);
+		t->state = up >= m ? up - m : up;
+	} else {
+		ll down = s - r;
+		t->part2 += q + (s <= r) - (s == 0);
+		t->state = down < 0 ? down + m : down;
+	}
+
+	t->part1 += (t->state == 0);
+	t->lines++;
+}
+
+static inline void dial_push(DialTracker *t, char dir, ll dist) {
+	if (t->modulus == 100) dial_push_mod(t, dir, dist, 100);
+	else dial_push_mod(t, dir, dist, t->modulus);
+}
+
+static bool dial_checkpoint_save(const DialTracker *t, const char *path) {
+	FILE *f = fopen(path, "w");
+	if (!f) return false;
+
+	fprintf(f, "%s\nmodulus %lld\nstate %lld\npart1 %lld\npart2 %lld\nlines %lld\n",
+	        DIAL_CHECKPOINT_MAGIC, t->modulus, t->state, t->part1, t->part2, t->lines);
+
+	return fclose(f) == 0;
+}
+
+static bool dial_checkpoint_load(DialTracker *t, const char *path) {
+	FILE *f = fopen(path, "r");
+	if (!f) return false;
+
+	char magic[32] = {0};
+	DialTracker c = {0};
+	int ok = fscanf(f, "%31[^\n] modulus %lld state %lld part1 %lld part2 %lld lines %lld",
+	                magic, &c.modulus, &c.state, &c.part1, &c.part2, &c.lines);
+	fclose(f);
+
+	if (ok != 6 || strcmp(magic, DIAL_CHECKPOINT_MAGIC) != 0) return false;
+	if (c.modulus <= 0 || c.state < 0 || c.state >= c.modulus) return false;
+
+	*t = c;
+	return true;
+}
+
+// --- Batched sequential kernel ---
+//
+// Rotations are parsed into SoA arrays DIAL_BATCH at a time. The div/mod of
+// every distance by 100 is done for the whole batch up front (AVX2 when the
+// CPU has it) with the reciprocal q = (d * 0x51EB851F) >> 37, exact for all
+// 32-bit d. With d = 100q + r and start state s, a rotation crosses 0
+//   R: q + [s + r >= 100]         L: q + [s <= r] - [s == 0]
+// times, so the remaining per-record chain is a few branchless scalar ops.
+
+#define DIAL_BATCH 16
+#define DIV100_MAGIC 0x51EB851FULL
+#define DIV100_SHIFT 37
+
+typedef struct {
+	uint dist[DIAL_BATCH];
+	uint q[DIAL_BATCH];
+	uint r[DIAL_BATCH];
+	uch right[DIAL_BATCH];
+	int count;
+} DialBatch;
+
+static void dial_divmod_scalar(DialBatch *b) {
+	for (int i = 0; i < b->count; ++i) {
+		uint q = (uint)(((ull)b->dist[i] * DIV100_MAGIC) >> DIV100_SHIFT);
+		b->q[i] = q;
+		b->r[i] = b->dist[i] - q * 100;
+	}
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+__attribute__((target("avx2")))
+static void dial_divmod_avx2(DialBatch *b) {
+	const __m256i magic = _mm256_set1_epi64x((ll)DIV100_MAGIC);
+	const __m256i hundred = _mm256_set1_epi32(100);
+
+	// Tail lanes past count hold stale values; they are computed and ignored
+	for (int i = 0; i < DIAL_BATCH; i += 8) {
+		__m256i d = _mm256_loadu_si256((const __m256i *)(b->dist + i));
+
+		// 32x32->64 products for even and odd lanes, then keep bits 37..68
+		__m256i even = _mm256_srli_epi64(_mm256_mul_epu32(d, magic), DIV100_SHIFT);
+		__m256i odd = _mm256_srli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(d, 32), magic), DIV100_SHIFT);
+		__m256i q = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+		__m256i r = _mm256_sub_epi32(d, _mm256_mullo_epi32(q, hundred));
+
+		_mm256_storeu_si256((__m256i *)(b->q + i), q);
+		_mm256_storeu_si256((__m256i *)(b->r + i), r);
+	}
+}
+#endif
+
+typedef void (*DialDivmodFn)(DialBatch *);
+
+static DialDivmodFn dial_pick_divmod(void) {
+#if defined(__x86_64__) || defined(__i386__)
+	if (__builtin_cpu_supports("avx2")) return dial_divmod_avx2;
+#endif
+	return dial_divmod_scalar;
+}
+
+static inline void dial_chain(const DialBatch *b, int *state_io, ll *part1, ll *part2) {
+	int s = *state_io;
+	ll hits = 0, cross = 0;
+
+	for (int i = 0; i < b->count; ++i) {
+		int r = (int)b->r[i];
+		int right = b->right[i];
+
+		int up = s + r;
+		int down = s - r;
+		int next = right ? (up >= 100 ? up - 100 : up) : (down < 0 ? down + 100 : down);
+		int extra = right ? (up >= 100) : ((s <= r) - (s == 0));
+
+		cross += b->q[i] + extra;
+		s = next;
+		hits += (s == 0);
+	}
+
+	*state_io = s;
+	*part1 += hits;
+	*part2 += cross;
+}
+
+static void solve(LineReader *input, DialTracker *t) {
+	Span line;
+
+	// Other dial sizes go through the generic tracker one rotation at a time
+	if (t->modulus != 100) {
+		while (reader_next_line(input, &line)) {
+			if (line.len == 0) continue;
+			dial_push(t, line.data[0], parse_distance(line.data + 1, line.len - 1));
+		}
+		return;
+	}
+
+	DialDivmodFn divmod = dial_pick_divmod();
+	DialBatch batch = {0};
+	int state = (int)t->state;
 	ll part1 = 0, part2 = 0;
-	
-	char *line = NULL;
-	size_t size = 0;
-	
-	while (getline_or_die(&line, &size, input) != -1) {
-		// Parse direction and distance
-		char dir = line[0];
-		int distance = (int)strtol(line + 1, NULL, 10);
-		
-		// Calculate distance to crossing point (state 0 or 100)
-		int dist_to_crossing = (dir == 'R') ? (100 - state) : state;
-		if (dist_to_crossing == 0) dist_to_crossing = 100;
-		
-		// Update state
+
+	bool more = true;
+	while (more) {
+		// Parse direction and distance into the batch
+		batch.count = 0;
+		while (batch.count < DIAL_BATCH && (more = reader_next_line(input, &line))) {
+			if (line.len == 0) continue;
+			batch.right[batch.count] = line.data[0] == 'R';
+			batch.dist[batch.count] = (uint)parse_distance(line.data + 1, line.len - 1);
+			batch.count++;
+		}
+
+		divmod(&batch);
+		dial_chain(&batch, &state, &part1, &part2);
+		t->lines += batch.count;
+	}
+
+	t->state = state;
+	t->part1 += part1;
+	t->part2 += part2;
+}
+
+// --- Parallel segment composition ---
+//
+// With unwrapped position p, a rotation crosses 0 exactly
+//   R d: floor((p + d) / 100) - floor(p / 100)
+//   L d: floor((p - 1) / 100) - floor((p - d - 1) / 100)
+// times. Over a chunk that starts at dial state s, p = s + offset, and each
+// floor((s + c) / 100) is floor(c / 100) plus one step at s = 100 - c mod 100.
+// So a chunk's hits and crossings as functions of s are built in O(1) per
+// rotation with a histogram and a difference array, and the chunks are then
+// composed by a sequential scan over their 100-entry tables.
+
+#define PARALLEL_MIN_BYTES (1u << 20)
+
+typedef struct {
+	Span text;
+	ll net;            // total unwrapped displacement of the chunk
+	ll base;           // crossings common to every start state
+	ll step[101];      // difference array of extra crossings over start state
+	ll hits[100];      // hits[s]: rotations ending on 0 when starting at s
+	ll lines;
+} Segment;
+
+static inline ll floor_div100(ll c) { return c >= 0 ? c / 100 : -((99 - c) / 100); }
+static inline int floor_mod100(ll c) { return (int)(c - floor_div100(c) * 100); }
+
+// Add sign * floor((s + c) / 100) to the chunk's crossing function
+static inline void segment_add_floor(Segment *seg, ll c, int sign) {
+	seg->base += sign * floor_div100(c);
+	int m = floor_mod100(c);
+	if (m) seg->step[100 - m] += sign;
+}
+
+static void *segment_summarize(void *arg) {
+	Segment *seg = arg;
+	ll off = 0;
+
+	Span rest = seg->text, line;
+	while (span_next_line(&rest, &line)) {
+		if (line.len == 0) continue;
+
+		char dir = line.data[0];
+		int distance = parse_distance(line.data + 1, line.len - 1);
+
 		if (dir == 'R') {
-			state = (state + distance) % 100;
+			segment_add_floor(seg, off + distance, +1);
+			segment_add_floor(seg, off, -1);
+			off += distance;
 		} else {
-			state = (state - distance) % 100;
-			if (state < 0) state += 100;
+			segment_add_floor(seg, off - 1, +1);
+			segment_add_floor(seg, off - distance - 1, -1);
+			off -= distance;
 		}
-		
-		// Part 1: Count crossings of 0/100
-		if (state == 0) part1++;
-		
-		// Part 2: Count all positions passing through 0/100
-		if (distance >= dist_to_crossing) {
-			part2 += 1 + (distance - dist_to_crossing) / 100;
+
+		seg->hits[floor_mod100(-off)]++;
+		seg->lines++;
+	}
+
+	seg->net = off;
+	return NULL;
+}
+
+static void solve_parallel(Span input, int threads, DialTracker *t) {
+	Span *pieces = xmalloc((size_t)threads * sizeof(Span));
+	int n = span_split_lines(input, threads, pieces);
+
+	Segment *segs = calloc((size_t)n, sizeof(Segment));
+	if (!segs) die("calloc failed");
+	for (int i = 0; i < n; ++i) segs[i].text = pieces[i];
+
+	parallel_run(n, segment_summarize, segs, sizeof(Segment));
+
+	// Compose the per-chunk tables left to right
+	int state = (int)t->state;
+	for (int i = 0; i < n; ++i) {
+		ll extra = 0;
+		for (int s = 0; s <= state; ++s) extra += segs[i].step[s];
+
+		t->part1 += segs[i].hits[state];
+		t->part2 += segs[i].base + extra;
+		t->lines += segs[i].lines;
+		state = floor_mod100(state + segs[i].net);
+	}
+	t->state = state;
+
+	free(segs);
+	free(pieces);
+}
+
+static void usage(const char *prog) {
+	fprintf(stderr, "Usage: %s <input_file> [--resume <ckpt>] [--checkpoint <ckpt>] [--modulus <n>]\n", prog);
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+	const char *resume = NULL, *checkpoint = NULL;
+	ll modulus = 100;
+	bool modulus_set = false;
+
+	for (int i = 2; i < argc; ++i) {
+		if (i + 1 >= argc) usage(argv[0]);
+		if (strcmp(argv[i], "--resume") == 0) resume = argv[++i];
+		else if (strcmp(argv[i], "--checkpoint") == 0) checkpoint = argv[++i];
+		else if (strcmp(argv[i], "--modulus") == 0) {
+			modulus = strtoll(argv[++i], NULL, 10);
+			modulus_set = true;
+		} else usage(argv[0]);
+	}
+	if (modulus <= 0) usage(argv[0]);
+
+	DialTracker t = dial_tracker_new(modulus);
+	if (resume && !dial_checkpoint_load(&t, resume)) {
+		fprintf(stderr, "Error: invalid checkpoint '%s'.\n", resume);
+		return 1;
+	}
+
+	// A resumed dial keeps the checkpoint's size
+	if (resume && modulus_set && modulus != t.modulus) {
+		fprintf(stderr, "Error: --modulus %lld does not match checkpoint modulus %lld.\n", modulus, t.modulus);
+		return 1;
+	}
+
+	// Regular files are mmapped, pipes are streamed in the background
+	LineReader input = reader_open_input_or_die(argc, argv);
+
+	// Unchanged input + unchanged binary: answer straight from the cache.
+	// Only plain full runs are cached: checkpointing needs the full state.
+	bool plain = !resume && !checkpoint && t.modulus == 100;
+	Cache cache = plain ? cache_open(1, input.map) : (Cache){0};
+	ll answers[2];
+	if (!cache_lookup(&cache, answers)) {
+		int threads = parallel_threads();
+		if (t.modulus == 100 && !input.stream && threads > 1 && input.map.len >= PARALLEL_MIN_BYTES) {
+			solve_parallel(input.map, threads, &t);
+		} else {
+			solve(&input, &t);
 		}
+		answers[0] = t.part1;
+		answers[1] = t.part2;
+		cache_store(&cache, answers);
 	}
 	
-	printf("Part 1: %lld\n", part1);
-	printf("Part 2: %lld\n", part2);
+	printf("Part 1: %lld\n", answers[0]);
+	printf("Part 2: %lld\n", answers[1]);
+
+	if (checkpoint && !dial_checkpoint_save(&t, checkpoint)) die("Error writing checkpoint");
 	
-	free(line);
-	fclose(input);
+	cache_close(&cache);
+	reader_close(&input);
 	
 	return 0;
 }
@@ -1,40 +1,327 @@
+#define PARALLEL_IMPLEMENTATION
 #include "../nob.h"
 
-// Optimized: Check for double repeat (ABABAB...)
-static inline bool is_double_repeat(const char *str, size_t len) {
-	if (len % 2 != 0 || len == 0) return false;
-	
-	size_t half = len / 2;
-	for (size_t i = 0; i < half; ++i) {
-		if (str[i] != str[i + half]) return false;
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+typedef struct {
+	ll left;
+	ll right;
+} Range;
+
+typedef struct {
+	Range *items;
+	size_t count;
+	size_t capacity;
+} Ranges;
+
+static inline int compare_ranges(const void *a, const void *b) {
+	ll x = ((const Range *)a)->left, y = ((const Range *)b)->left;
+	return (x > y) - (x < y);
+}
+
+// Sort and merge overlapping/adjacent ranges so no ID is counted twice, then
+// split the result at powers of ten so every piece has a single digit length
+static void normalize_ranges(Ranges *ranges) {
+	qsort(ranges->items, ranges->count, sizeof(Range), compare_ranges);
+
+	Ranges merged = {0};
+	for (size_t i = 0; i < ranges->count; ++i) {
+		Range r = ranges->items[i];
+		if (r.left > r.right) continue;
+
+		if (merged.count > 0 && r.left - 1 <= da_last(&merged).right) {
+			if (r.right > da_last(&merged).right) da_last(&merged).right = r.right;
+		} else {
+			da_append(&merged, r);
+		}
+	}
+
+	ranges->count = 0;
+	for (size_t i = 0; i < merged.count; ++i) {
+		Range r = merged.items[i];
+		for (ll p = 10;; p *= 10) {
+			if (p > r.left && p <= r.right) {
+				da_append(ranges, ((Range){ r.left, p - 1 }));
+				r.left = p;
+			}
+			if (p > r.right || p > LLONG_MAX / 10) break;
+		}
+		da_append(ranges, r);
+	}
+
+	da_free(&merged);
+}
+
+// --- Brute-force verifier ---
+//
+// Walks every number without formatting: the prefix (all digits but the
+// last) lives in a decimal buffer that is incremented in place, and the ten
+// numbers sharing a prefix are tested together. For a period k | L the prefix
+// must repeat with period k, and then exactly one last digit (the one k
+// places back) completes the pattern, so each decade costs one byte-compare
+// of the prefix per divisor of L.
+
+#define VERIFY_BUF 48
+
+static int divisors[20][20];   // divisors[L]: proper divisors of L, 0-terminated
+
+static void init_divisors(void) {
+	for (int len = 1; len < 20; ++len) {
+		int n = 0;
+		for (int k = 1; k < len; ++k) {
+			if (len % k == 0) divisors[len][n++] = k;
+		}
+		divisors[len][n] = 0;
+	}
+}
+
+// Do buf[i] == buf[i + k] hold for all i < n (n <= 18)?
+static inline bool prefix_has_period(const char *buf, int k, int n) {
+	if (n <= 0) return true;
+	uint want = (1u << n) - 1;
+#if defined(__SSE2__)
+	__m128i lo = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)buf), _mm_loadu_si128((const __m128i *)(buf + k)));
+	__m128i hi = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(buf + 16)), _mm_loadu_si128((const __m128i *)(buf + 16 + k)));
+	uint eq = (uint)_mm_movemask_epi8(lo) | ((uint)_mm_movemask_epi8(hi) << 16);
+	return (eq & want) == want;
+#else
+	for (int i = 0; i < n; ++i) {
+		if (buf[i] != buf[i + k]) return false;
 	}
 	return true;
+#endif
 }
 
-// Optimized: Check for any repeating pattern
-// Uses divisors check - much faster than checking all lengths
-static inline bool is_multi_repeat(const char *str, size_t len) {
-	if (len <= 1) return false;
-	
-	// Only check divisors of length
-	for (size_t divisor = 1; divisor <= len / 2; ++divisor) {
-		if (len % divisor != 0) continue;
-		
-		// Check if pattern repeats every 'divisor' chars
-		bool match = true;
-		for (size_t i = divisor; i < len; ++i) {
-			if (str[i] != str[i % divisor]) {
-				match = false;
-				break;
+// Write the decimal digits of x into buf; returns the length
+static int to_digits(ll x, char *buf) {
+	char tmp[20];
+	int n = 0;
+	do { tmp[n++] = (char)('0' + x % 10); x /= 10; } while (x);
+	for (int i = 0; i < n; ++i) buf[i] = tmp[n - 1 - i];
+	return n;
+}
+
+static void verify_range(ll lo, ll hi, i128 *part1, i128 *part2) {
+	// Single digits never repeat
+	if (lo < 10) lo = 10;
+	if (lo > hi) return;
+
+	char buf[VERIFY_BUF] = {0};
+	int len = to_digits(lo, buf);
+	ll prefix = lo / 10;
+
+	while (prefix <= hi / 10) {
+		ll base = prefix * 10;
+		int dlo = base < lo ? (int)(lo - base) : 0;
+		int dhi = hi - base < 9 ? (int)(hi - base) : 9;
+
+		uint hits = 0;
+		for (const int *k = divisors[len]; *k; ++k) {
+			if (!prefix_has_period(buf, *k, len - 1 - *k)) continue;
+
+			int d = buf[len - 1 - *k] - '0';
+			if (d < dlo || d > dhi) continue;
+
+			hits |= 1u << d;
+			if (2 * *k == len) *part1 += base + d;
+		}
+		for (int d = dlo; d <= dhi; ++d) {
+			if (hits >> d & 1) *part2 += base + d;
+		}
+
+		// Increment the prefix in place; a full carry adds a digit
+		prefix++;
+		int i = len - 2;
+		while (i >= 0 && buf[i] == '9') buf[i--] = '0';
+		if (i >= 0) {
+			buf[i]++;
+		} else {
+			len++;
+			buf[0] = '1';
+			memset(buf + 1, '0', (size_t)len - 1);
+		}
+	}
+}
+
+typedef struct {
+	const Ranges *ranges;
+	int index;         // this worker takes slice `index` of `count` of every range
+	int count;
+	i128 part1;
+	i128 part2;
+} VerifyJob;
+
+static void *verify_worker(void *arg) {
+	VerifyJob *job = arg;
+
+	for (size_t i = 0; i < job->ranges->count; ++i) {
+		ll a = job->ranges->items[i].left, b = job->ranges->items[i].right;
+		if (a > b) continue;
+
+		ull span = (ull)(b - a) + 1;
+		ll from = a + (ll)(span / (ull)job->count * (ull)job->index);
+		ll to = job->index == job->count - 1 ? b : a + (ll)(span / (ull)job->count * (ull)(job->index + 1)) - 1;
+		verify_range(from, to, &job->part1, &job->part2);
+	}
+
+	return NULL;
+}
+
+static void solve_brute(const Ranges *ranges, i128 *part1, i128 *part2) {
+	init_divisors();
+
+	int threads = parallel_threads();
+	VerifyJob *jobs = calloc((size_t)threads, sizeof(VerifyJob));
+	if (!jobs) die("calloc failed");
+	for (int i = 0; i < threads; ++i) jobs[i] = (VerifyJob){ .ranges = ranges, .index = i, .count = threads };
+
+	parallel_run(threads, verify_worker, jobs, sizeof(VerifyJob));
+
+	for (int i = 0; i < threads; ++i) {
+		*part1 += jobs[i].part1;
+		*part2 += jobs[i].part2;
+	}
+	free(jobs);
+}
+
+// --- Closed-form prefix queries ---
+//
+// An L-digit base-B number made of L/k copies of a k-digit block is
+// block * (B^L - 1) / (B^k - 1), so G(k), the k-periodic L-digit numbers
+// <= x, form an arithmetic series in the block. Every such number has a
+// minimal period m | k, hence G(k) = sum over m | k of E(m) and the numbers
+// of minimal period exactly m are E(m) = sum over d | m of mu(m / d) G(d).
+// A predicate is a condition on (m, L / m), and F(x) sums E(m) over the
+// lengths of x and the divisors that satisfy it: polylogarithmic in x.
+// Any range is then F(b) - F(a - 1).
+
+#define MAX_LEN 64
+
+typedef struct {
+	int base;          // digit base B (2..36)
+	int min_repeats;   // at least this many copies of the block
+	int repeats_mod;   // number of copies is a multiple of this (0: any)
+	int period;        // minimal period is exactly this (0: any)
+} RepeatPredicate;
+
+typedef struct {
+	i128 count;
+	i128 sum;
+} Tally;
+
+// Part 1: the two halves match, i.e. an even number of copies
+static const RepeatPredicate PART1_PRED = { .base = 10, .min_repeats = 2, .repeats_mod = 2 };
+// Part 2: at least two copies of some block
+static const RepeatPredicate PART2_PRED = { .base = 10, .min_repeats = 2 };
+
+// Moebius function for the small d (<= 64) that show up here
+static int mobius(int d) {
+	int m = 1;
+	for (int p = 2; p * p <= d; ++p) {
+		if (d % p) continue;
+		d /= p;
+		if (d % p == 0) return 0;
+		m = -m;
+	}
+	return d > 1 ? -m : m;
+}
+
+static bool predicate_accepts(const RepeatPredicate *pred, int len, int m) {
+	int repeats = len / m;
+	if (repeats < pred->min_repeats) return false;
+	if (pred->repeats_mod > 0 && repeats % pred->repeats_mod) return false;
+	if (pred->period > 0 && m != pred->period) return false;
+	return true;
+}
+
+// G(k): k-periodic len-digit numbers <= x; pw[i] = B^i
+static Tally periodic_prefix(const i128 *pw, int len, int k, ll x) {
+	i128 mult = 0;
+	for (int i = 0; i < len; i += k) mult = mult * pw[k] + 1;
+
+	i128 from = pw[k - 1], to = x / mult;
+	if (to > pw[k] - 1) to = pw[k] - 1;
+	if (from > to) return (Tally){0};
+
+	i128 n = to - from + 1;
+	return (Tally){ n, mult * ((from + to) * n / 2) };
+}
+
+// F(x): count and sum of IDs in [1, x] matching the predicate
+static Tally repeat_prefix(const RepeatPredicate *pred, ll x) {
+	Tally total = {0};
+	if (x <= 0) return total;
+
+	// Powers up to the first one above x; B^len is then always available
+	i128 pw[MAX_LEN + 2];
+	pw[0] = 1;
+	for (int i = 1; i < MAX_LEN + 2 && pw[i - 1] <= x; ++i) pw[i] = pw[i - 1] * pred->base;
+
+	for (int len = 1; len <= MAX_LEN && pw[len - 1] <= x; ++len) {
+		Tally g[MAX_LEN + 1];
+		for (int k = 1; k <= len; ++k) {
+			if (len % k == 0) g[k] = periodic_prefix(pw, len, k, x);
+		}
+
+		for (int m = 1; m <= len; ++m) {
+			if (len % m || !predicate_accepts(pred, len, m)) continue;
+			for (int d = 1; d <= m; ++d) {
+				if (m % d) continue;
+				int mu = mobius(m / d);
+				total.count += mu * g[d].count;
+				total.sum += mu * g[d].sum;
 			}
 		}
-		
-		if (match) return true;
 	}
-	return false;
+
+	return total;
+}
+
+static Tally repeat_range(const RepeatPredicate *pred, ll a, ll b) {
+	Tally hi = repeat_prefix(pred, b), lo = repeat_prefix(pred, a - 1);
+	return (Tally){ hi.count - lo.count, hi.sum - lo.sum };
+}
+
+static void solve_closed(ll a, ll b, i128 *part1, i128 *part2) {
+	*part1 += repeat_range(&PART1_PRED, a, b).sum;
+	*part2 += repeat_range(&PART2_PRED, a, b).sum;
+}
+
+// Parse "base=B,min=K,mod=C,period=P" (any subset, any order)
+static bool parse_predicate(const char *spec, RepeatPredicate *pred) {
+	*pred = (RepeatPredicate){ .base = 10, .min_repeats = 2 };
+
+	while (*spec) {
+		char key[16];
+		int value, used;
+		if (sscanf(spec, "%15[a-z]=%d%n", key, &value, &used) != 2) return false;
+
+		if (strcmp(key, "base") == 0) pred->base = value;
+		else if (strcmp(key, "min") == 0) pred->min_repeats = value;
+		else if (strcmp(key, "mod") == 0) pred->repeats_mod = value;
+		else if (strcmp(key, "period") == 0) pred->period = value;
+		else return false;
+
+		spec += used;
+		if (*spec == ',') spec++;
+	}
+
+	return pred->base >= 2 && pred->base <= 36 && pred->min_repeats >= 1
+	    && pred->repeats_mod >= 0 && pred->period >= 0;
 }
 
 int main(int argc, char **argv) {
+	bool brute = argc > 2 && strcmp(argv[2], "--brute") == 0;
+	bool query = argc > 3 && strcmp(argv[2], "--query") == 0;
+
+	RepeatPredicate pred;
+	if (query && !parse_predicate(argv[3], &pred)) {
+		fprintf(stderr, "Error: bad predicate '%s' (expected base=B,min=K,mod=C,period=P).\n", argv[3]);
+		return 1;
+	}
+
 	FILE *input = open_input_or_die(argc, argv);
 	
 	char *line = NULL;
@@ -50,37 +337,53 @@ int main(int argc, char **argv) {
 	
 	if (len > 0 && line[len - 1] == '\n') line[len - 1] = '\0';
 	
-	ll part1 = 0, part2 = 0;
-	
-	// Parse ranges directly without storing entire line
+	// Collect every range so they can be merged and split before solving
+	Ranges ranges = {0};
 	const char *p = line;
 	while (*p) {
 		// Parse range: a-b
-		ll a = strtoll(p, (char **)&p, 10);
+		Range r;
+		r.left = strtoll(p, (char **)&p, 10);
 		if (*p != '-') break;
 		p++;
 		
-		ll b = strtoll(p, (char **)&p, 10);
+		r.right = strtoll(p, (char **)&p, 10);
 		if (*p == ',') p++;
-		
-		// Process each number in range
-		for (ll x = a; x <= b; ++x) {
-			char buf[32];
-			int buf_len = snprintf(buf, sizeof(buf), "%lld", x);
-			
-			// Check repeating patterns on the number string itself
-			if (is_double_repeat(buf, (size_t)buf_len)) {
-				part1 += x;
-			}
-			if (is_multi_repeat(buf, (size_t)buf_len)) {
-				part2 += x;
-			}
+
+		da_append(&ranges, r);
+	}
+	free(line);
+
+	// Fewer, disjoint, same-length work items for every engine
+	normalize_ranges(&ranges);
+	
+	i128 part1 = 0, part2 = 0;
+	Tally matched = {0};
+
+	if (brute) solve_brute(&ranges, &part1, &part2);
+
+	for (size_t i = 0; i < ranges.count && !brute; ++i) {
+		ll a = ranges.items[i].left, b = ranges.items[i].right;
+		if (query) {
+			Tally t = repeat_range(&pred, a, b);
+			matched.count += t.count;
+			matched.sum += t.sum;
+		} else {
+			solve_closed(a, b, &part1, &part2);
 		}
 	}
 	
-	printf("Part1: %lld\n", part1);
-	printf("Part2: %lld\n", part2);
+	char buf[48];
+	if (query) {
+		printf("Count: %s\n", i128_to_str(matched.count, buf));
+		printf("Sum: %s\n", i128_to_str(matched.sum, buf));
+		da_free(&ranges);
+		return 0;
+	}
+
+	printf("Part1: %s\n", i128_to_str(part1, buf));
+	printf("Part2: %s\n", i128_to_str(part2, buf));
 	
-	free(line);
+	da_free(&ranges);
 	return 0;
 }
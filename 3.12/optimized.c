@@ -1,8 +1,83 @@
+#define MMAP_IMPLEMENTATION
+#define STREAM_IMPLEMENTATION
+#define PARALLEL_IMPLEMENTATION
 #include "../nob.h"
 
+// SIMD Part 1 for long banks: with prefix max m[i] of the digits, the best
+// pair ending at i is 10 * m[i - 1] + d[i]. m is a max-scan inside each
+// 32-byte block (log-step shifts, then the low lane's max carried into the
+// high lane) seeded with the running max of the earlier blocks, so there is
+// no per-digit dependency chain; the answer is a horizontal max.
+
+#define PART1_SIMD_MIN_LEN 64
+
+static bool use_avx2;
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+__attribute__((target("avx2")))
+static ll Part1_avx2(const char *line, int len) {
+	const __m256i zero_char = _mm256_set1_epi8('0');
+	const __m256i lane_last = _mm256_set1_epi8(15);
+	__m256i best = _mm256_setzero_si256();
+	uch carry = (uch)(line[0] - '0');
+
+	int i = 1;
+	for (; i + 32 <= len; i += 32) {
+		__m256i d = _mm256_sub_epi8(_mm256_loadu_si256((const __m256i *)(line + i)), zero_char);
+
+		// Inclusive max-scan within each 128-bit lane
+		__m256i m = d;
+		m = _mm256_max_epu8(m, _mm256_slli_si256(m, 1));
+		m = _mm256_max_epu8(m, _mm256_slli_si256(m, 2));
+		m = _mm256_max_epu8(m, _mm256_slli_si256(m, 4));
+		m = _mm256_max_epu8(m, _mm256_slli_si256(m, 8));
+
+		// Carry the low lane's max into the high lane, and the earlier blocks' max into all
+		__m256i lane_max = _mm256_shuffle_epi8(m, lane_last);
+		m = _mm256_max_epu8(m, _mm256_permute2x128_si256(lane_max, lane_max, 0x08));
+		m = _mm256_max_epu8(m, _mm256_set1_epi8((char)carry));
+
+		// Exclusive scan: shift one byte across lanes, seed byte 0 with the carry
+		__m256i prev = _mm256_alignr_epi8(m, _mm256_permute2x128_si256(m, m, 0x08), 15);
+		prev = _mm256_max_epu8(prev, _mm256_zextsi128_si256(_mm_cvtsi32_si128(carry)));
+
+		// 10 * prev + d stays below 100, so byte arithmetic is exact
+		__m256i p2 = _mm256_add_epi8(prev, prev);
+		__m256i p8 = _mm256_add_epi8(_mm256_add_epi8(p2, p2), _mm256_add_epi8(p2, p2));
+		best = _mm256_max_epu8(best, _mm256_add_epi8(_mm256_add_epi8(p8, p2), d));
+
+		carry = (uch)_mm256_extract_epi8(m, 31);
+	}
+
+	// Horizontal max
+	__m128i h = _mm_max_epu8(_mm256_castsi256_si128(best), _mm256_extracti128_si256(best, 1));
+	h = _mm_max_epu8(h, _mm_srli_si128(h, 8));
+	h = _mm_max_epu8(h, _mm_srli_si128(h, 4));
+	h = _mm_max_epu8(h, _mm_srli_si128(h, 2));
+	h = _mm_max_epu8(h, _mm_srli_si128(h, 1));
+	int max_joltage = _mm_cvtsi128_si32(h) & 0xff;
+
+	// Scalar tail
+	int first_digit = carry;
+	for (; i < len; ++i) {
+		int second_digit = line[i] - '0';
+		if (first_digit * 10 + second_digit > max_joltage) max_joltage = first_digit * 10 + second_digit;
+		if (second_digit > first_digit) first_digit = second_digit;
+	}
+
+	return max_joltage;
+}
+#endif
+
 // Optimized Part 1: O(n) instead of O(n^2)
 // Find max 2-digit number by tracking best pair
 static inline ll Part1(const char *line, int len) {
+#if defined(__x86_64__) || defined(__i386__)
+	if (use_avx2 && len >= PART1_SIMD_MIN_LEN) return Part1_avx2(line, len);
+#endif
+
 	ll max_joltage = 0;
 	
 	// Track the largest digit seen so far
@@ -26,64 +101,344 @@ static inline ll Part1(const char *line, int len) {
 }
 
 // Optimized Part 2: Monge's algorithm (greedy stack)
+//
+// Only the first 12 stack slots can survive, so a digit that would land
+// past them is dropped instead (that spends one removal, exactly as pushing
+// and later trimming it would). Knowing how many digits are still to come
+// is all the pop rule needs, so memory is O(12) whatever the bank length.
+
+#define PART2_DIGITS 12
+
+typedef struct {
+	char stack[PART2_DIGITS];
+	int top;
+	ll remaining;      // digits not yet pushed, the current one included
+} GreedyStack;
+
+static inline void greedy_push(GreedyStack *g, char current) {
+	// Remove smaller digits while enough digits remain to refill the stack
+	while (g->top > 0 && g->stack[g->top - 1] < current && g->top - 1 + g->remaining >= PART2_DIGITS) {
+		g->top--;
+	}
+
+	if (g->top < PART2_DIGITS) g->stack[g->top++] = current;
+	g->remaining--;
+}
+
+static inline ll greedy_value(const GreedyStack *g) {
+	if (g->top < PART2_DIGITS) return 0;
+
+	// Convert to number using Horner's method
+	ll joltage = 0;
+	for (int i = 0; i < PART2_DIGITS; ++i) {
+		joltage = joltage * 10 + (g->stack[i] - '0');
+	}
+	return joltage;
+}
+
 static inline ll Part2(const char *line, int len) {
-	if (len < 12) return 0;
+	if (len < PART2_DIGITS) return 0;
 	
-	int digits_to_remove = len - 12;
-	char stack[len];
-	int top = 0;
+	GreedyStack g = { .remaining = len };
+	for (int i = 0; i < len; ++i) greedy_push(&g, line[i]);
 	
-	// Greedily build largest 12-digit number
-	for (int i = 0; i < len; ++i) {
-		char current = line[i];
-		
-		// Remove smaller digits to make room for larger ones
-		while (top > 0 && digits_to_remove > 0 && stack[top - 1] < current) {
-			top--;
-			digits_to_remove--;
+	return greedy_value(&g);
+}
+
+// --- Chunked streaming ---
+//
+// For banks too large to hold in memory: a first pass over the file records
+// each line's digit count, a second pass feeds fixed-size chunks straight
+// into the per-line Part 1 state and greedy stack. Needs a seekable input.
+
+#define STREAM_CHUNK (1u << 20)
+
+typedef struct {
+	ll *items;
+	size_t count;
+	size_t capacity;
+} LineLengths;
+
+static ssize_t read_chunk_or_die(int fd, char *buf) {
+	ssize_t n = read(fd, buf, STREAM_CHUNK);
+	if (n < 0) die("read failed");
+	return n;
+}
+
+static void solve_chunked(const char *path, ll *part1, ll *part2) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) die("Error opening input file");
+
+	char *buf = xmalloc(STREAM_CHUNK);
+	LineLengths lengths = {0};
+	ssize_t n;
+
+	// Pass 1: digit count of every line
+	ll cur = 0;
+	while ((n = read_chunk_or_die(fd, buf)) > 0) {
+		for (ssize_t i = 0; i < n; ++i) {
+			if (buf[i] == '\n') { da_append(&lengths, cur); cur = 0; }
+			else if (buf[i] != '\r') cur++;
 		}
-		
-		stack[top++] = current;
 	}
-	
-	// Remove remaining digits if needed
-	top -= digits_to_remove;
-	
-	// Convert to number using Horner's method
-	ll joltage = 0;
-	for (int i = 0; i < 12; ++i) {
-		joltage = joltage * 10 + (stack[i] - '0');
+	if (cur > 0) da_append(&lengths, cur);
+
+	if (lseek(fd, 0, SEEK_SET) < 0) die("--stream needs a seekable input");
+
+	// Pass 2: feed each line's digits through the O(1)-memory states
+	size_t line_no = 0;
+	int first_digit = -1, max_joltage = 0;
+	GreedyStack g = { .remaining = lengths.count ? lengths.items[0] : 0 };
+
+	while ((n = read_chunk_or_die(fd, buf)) > 0) {
+		for (ssize_t i = 0; i < n; ++i) {
+			char c = buf[i];
+			if (c == '\r') continue;
+
+			if (c == '\n') {
+				if (line_no < lengths.count && lengths.items[line_no] > 0) {
+					*part1 += max_joltage;
+					*part2 += greedy_value(&g);
+				}
+				line_no++;
+				first_digit = -1;
+				max_joltage = 0;
+				g = (GreedyStack){ .remaining = line_no < lengths.count ? lengths.items[line_no] : 0 };
+				continue;
+			}
+
+			// Part 1: best pair with the largest digit seen so far
+			int digit = c - '0';
+			if (first_digit >= 0 && first_digit * 10 + digit > max_joltage) max_joltage = first_digit * 10 + digit;
+			if (digit > first_digit) first_digit = digit;
+
+			if (lengths.items[line_no] >= PART2_DIGITS) greedy_push(&g, c);
+		}
 	}
-	
-	return joltage;
+	if (line_no < lengths.count && lengths.items[line_no] > 0) {
+		*part1 += max_joltage;
+		*part2 += greedy_value(&g);
+	}
+
+	da_free(&lengths);
+	free(buf);
+	close(fd);
+}
+
+// --- Parallel batch ---
+//
+// Banks are independent: split the mmapped input into line-aligned chunks,
+// one per thread, sum both parts locally and reduce at the end.
+
+#define PARALLEL_MIN_BYTES (1u << 20)
+
+typedef struct {
+	Span text;
+	ll part1;
+	ll part2;
+} BankJob;
+
+static void *bank_worker(void *arg) {
+	BankJob *job = arg;
+
+	Span rest = job->text, line;
+	while (span_next_line(&rest, &line)) {
+		if (line.len == 0) continue;
+		job->part1 += Part1(line.data, (int)line.len);
+		job->part2 += Part2(line.data, (int)line.len);
+	}
+
+	return NULL;
+}
+
+static void solve_parallel(Span input, int threads, ll *part1, ll *part2) {
+	BankJob *jobs = calloc((size_t)threads, sizeof(BankJob));
+	Span *pieces = xmalloc((size_t)threads * sizeof(Span));
+	if (!jobs) die("calloc failed");
+
+	int n = span_split_lines(input, threads, pieces);
+	for (int i = 0; i < n; ++i) jobs[i].text = pieces[i];
+
+	parallel_run(n, bank_worker, jobs, sizeof(BankJob));
+
+	for (int i = 0; i < n; ++i) {
+		*part1 += jobs[i].part1;
+		*part2 += jobs[i].part2;
+	}
+
+	free(pieces);
+	free(jobs);
+}
+
+// --- All-K selection ---
+//
+// A sparse table of leftmost-maximum positions answers "largest digit in
+// [l, r]" in O(1). The best K-digit subsequence picks, for digit i, the
+// leftmost maximum in [prev + 1, len - K + i], so once the table is built
+// every K costs O(K) and all K up to a limit cost O(len log len + sum K).
+// Sums are kept as decimal bigints since K may exceed what i128 holds.
+
+typedef struct {
+	int *items;        // items[j * len + i]: argmax of [i, i + 2^j)
+	size_t count;
+	size_t capacity;
+	int len;
+} BankIndex;
+
+typedef struct {
+	uch *items;        // little-endian decimal digits
+	size_t count;
+	size_t capacity;
+} BigDec;
+
+static void bank_index_build(BankIndex *idx, const char *line, int len) {
+	int levels = 1;
+	while ((1 << levels) <= len) levels++;
+
+	idx->len = len;
+	idx->count = 0;
+	da_reserve(idx, (size_t)levels * (size_t)len);
+	idx->count = (size_t)levels * (size_t)len;
+
+	for (int i = 0; i < len; ++i) idx->items[i] = i;
+
+	for (int j = 1; j < levels; ++j) {
+		const int *prev = idx->items + (size_t)(j - 1) * len;
+		int *cur = idx->items + (size_t)j * len;
+		int half = 1 << (j - 1);
+
+		for (int i = 0; i + (1 << j) <= len; ++i) {
+			int a = prev[i], b = prev[i + half];
+			cur[i] = line[a] >= line[b] ? a : b;
+		}
+	}
+}
+
+// Leftmost position of the largest digit in line[l..r]
+static inline int bank_index_argmax(const BankIndex *idx, const char *line, int l, int r) {
+	int j = 31 - __builtin_clz((uint)(r - l + 1));
+	const int *row = idx->items + (size_t)j * idx->len;
+	int a = row[l], b = row[r - (1 << j) + 1];
+	return line[a] >= line[b] ? a : b;
+}
+
+// Best k-digit subsequence of the bank, written to out as ASCII digits
+static void bank_best_k(const BankIndex *idx, const char *line, int k, char *out) {
+	int pos = 0;
+	for (int i = 0; i < k; ++i) {
+		int p = bank_index_argmax(idx, line, pos, idx->len - k + i);
+		out[i] = line[p];
+		pos = p + 1;
+	}
+}
+
+static void bigdec_add(BigDec *acc, const char *digits, int n) {
+	if (acc->count < (size_t)n) {
+		da_reserve(acc, (size_t)n);
+		memset(acc->items + acc->count, 0, (size_t)n - acc->count);
+		acc->count = (size_t)n;
+	}
+
+	int carry = 0;
+	for (size_t i = 0; i < acc->count; ++i) {
+		int d = acc->items[i] + carry + (i < (size_t)n ? digits[n - 1 - i] - '0' : 0);
+		if (i >= (size_t)n && carry == 0) break;
+		acc->items[i] = (uch)(d % 10);
+		carry = d / 10;
+	}
+	if (carry) da_append(acc, (uch)carry);
+}
+
+static void bigdec_print(const BigDec *b) {
+	size_t n = b->count;
+	while (n > 1 && b->items[n - 1] == 0) n--;
+	if (n == 0) putchar('0');
+	for (size_t i = n; i-- > 0;) putchar('0' + b->items[i]);
+}
+
+// Print, for every K in 1..limit, the sum over banks of the best K digits
+static void solve_all_k(LineReader *input, int limit) {
+	BankIndex idx = {0};
+	BigDec *sums = calloc((size_t)limit + 1, sizeof(BigDec));
+	char *digits = xmalloc((size_t)limit + 1);
+	if (!sums) die("calloc failed");
+
+	Span line;
+	while (reader_next_line(input, &line)) {
+		int len = (int)line.len;
+		if (len == 0) continue;
+
+		bank_index_build(&idx, line.data, len);
+		for (int k = 1; k <= limit && k <= len; ++k) {
+			bank_best_k(&idx, line.data, k, digits);
+			bigdec_add(&sums[k], digits, k);
+		}
+	}
+
+	for (int k = 1; k <= limit; ++k) {
+		printf("K=%d: ", k);
+		bigdec_print(&sums[k]);
+		putchar('\n');
+		da_free(&sums[k]);
+	}
+
+	free(sums);
+	free(digits);
+	da_free(&idx);
 }
 
 int main(int argc, char *argv[]) {
-	FILE *file = open_input_or_die(argc, argv);
+#if defined(__x86_64__) || defined(__i386__)
+	use_avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+	int all_k = 0;
+	bool chunked = false;
+	if (argc > 3 && strcmp(argv[2], "--all-k") == 0) all_k = atoi(argv[3]);
+	else if (argc == 3 && strcmp(argv[2], "--stream") == 0) chunked = true;
+	else if (argc > 2) {
+		fprintf(stderr, "Usage: %s <input_file> [--all-k <limit> | --stream]\n", argv[0]);
+		return 1;
+	}
+
+	if (chunked) {
+		ll part1 = 0, part2 = 0;
+		solve_chunked(argv[1], &part1, &part2);
+		printf("Part 1: %lld\n", part1);
+		printf("Part 2: %lld\n", part2);
+		return 0;
+	}
+
+	// Regular files are mmapped, pipes are streamed in the background
+	LineReader input = reader_open_input_or_die(argc, argv);
+
+	if (all_k > 0) {
+		solve_all_k(&input, all_k);
+		reader_close(&input);
+		return 0;
+	}
 	
-	char *line = NULL;
-	size_t len = 0;
-	ssize_t read;
+	Span line;
 	ll part1 = 0, part2 = 0;
-	
-	while ((read = getline_or_die(&line, &len, file)) != -1) {
-		// Remove trailing newline
-		int line_len = (int)strlen(line);
-		if (line_len > 0 && line[line_len - 1] == '\n') {
-			line_len--;
-		}
-		
-		if (line_len > 0) {
-			part1 += Part1(line, line_len);
-			part2 += Part2(line, line_len);
+
+	int threads = parallel_threads();
+	if (!input.stream && threads > 1 && input.map.len >= PARALLEL_MIN_BYTES) {
+		solve_parallel(input.map, threads, &part1, &part2);
+	} else {
+		while (reader_next_line(&input, &line)) {
+			int line_len = (int)line.len;
+			
+			if (line_len > 0) {
+				part1 += Part1(line.data, line_len);
+				part2 += Part2(line.data, line_len);
+			}
 		}
 	}
 	
 	printf("Part 1: %lld\n", part1);
 	printf("Part 2: %lld\n", part2);
 	
-	free(line);
-	fclose(file);
+	reader_close(&input);
 	
 	return 0;
 }
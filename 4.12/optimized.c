@@ -1,3 +1,6 @@
+#define MMAP_IMPLEMENTATION
+#define STREAM_IMPLEMENTATION
+#define PARALLEL_IMPLEMENTATION
 #include "../nob.h"
 
 typedef struct {
@@ -11,86 +14,590 @@ static const int dr[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
 static const int dc[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
 
 // Fast neighbor counting with bounds checking
-static inline int count_neighbors(const Matrix *m, int size, int i, int j) {
+static inline int count_neighbors(const Matrix *m, int rows, int cols, int i, int j) {
 	int neighbors = 0;
 	for (int k = 0; k < 8; ++k) {
 		int nr = i + dr[k];
 		int nc = j + dc[k];
-		if (nr >= 0 && nr < size && nc >= 0 && nc < size && m->items[nr][nc] == '@') {
+		if (nr >= 0 && nr < rows && nc >= 0 && nc < cols && m->items[nr][nc] == '@') {
 			neighbors++;
 		}
 	}
 	return neighbors;
 }
 
-int main(int argc, char **argv) {
-	FILE *input = open_input_or_die(argc, argv);
-	
-	Matrix m = {0};
-	char *line = NULL;
-	size_t len = 0;
-	ssize_t read;
+// --- Packed rows ---
+//
+// Each row is a bitset of '@' cells, 64 per word (bit j = column 64w + j).
+// The 8 neighbor masks of a word are the west/center/east shifts of the row
+// above and below plus west/east of the row itself; a carry-save adder
+// network sums them bit-sliced. With two full adders and a half adder for
+// the eight inputs and one more full adder for their low bits, a cell has 4+
+// neighbors exactly when at least two of the four weight-2 carries are set.
 
-	while ((read = getline_or_die(&line, &len, input)) != -1) {
-		line[strcspn(line, "\r\n")] = '\0';
-		da_append(&m, strdup(line));
+typedef struct {
+	int rows;
+	int cols;
+	int words;         // words per row
+	ull *bits;
+} BitGrid;
+
+static BitGrid bitgrid_from_matrix(const Matrix *m, int rows, int cols) {
+	BitGrid g = { .rows = rows, .cols = cols, .words = (cols + 63) / 64 };
+	if (rows <= 0 || cols <= 0) return g;
+
+	g.bits = (ull *)calloc((size_t)rows * (size_t)g.words, sizeof(ull));
+	if (!g.bits) die("calloc failed");
+
+	for (int i = 0; i < rows; ++i) {
+		for (int j = 0; j < cols; ++j) {
+			if (m->items[i][j] == '@') g.bits[(size_t)i * g.words + j / 64] |= 1ULL << (j % 64);
+		}
 	}
+	return g;
+}
 
-	fclose(input);
-	free(line);
+// Word w of row r, zero outside the grid
+static inline ull bitgrid_word(const BitGrid *g, int r, int w) {
+	if (r < 0 || r >= g->rows || w < 0 || w >= g->words) return 0;
+	return g->bits[(size_t)r * g->words + w];
+}
+
+static inline void full_add(ull a, ull b, ull c, ull *sum, ull *carry) {
+	ull t = a ^ b;
+	*sum = t ^ c;
+	*carry = (a & b) | (c & t);
+}
+
+// Cells of word w in row r that have fewer than 4 neighbors
+static inline ull bitgrid_accessible_word(const BitGrid *g, int r, int w) {
+	ull n[8], up[3], mid[3], dn[3];
+	for (int k = -1; k <= 1; ++k) {
+		up[k + 1] = bitgrid_word(g, r - 1, w + k);
+		mid[k + 1] = bitgrid_word(g, r, w + k);
+		dn[k + 1] = bitgrid_word(g, r + 1, w + k);
+	}
+
+	// West neighbor of column c is column c - 1, i.e. shift toward higher bits
+	n[0] = (up[1] << 1) | (up[0] >> 63);
+	n[1] = up[1];
+	n[2] = (up[1] >> 1) | (up[2] << 63);
+	n[3] = (mid[1] << 1) | (mid[0] >> 63);
+	n[4] = (mid[1] >> 1) | (mid[2] << 63);
+	n[5] = (dn[1] << 1) | (dn[0] >> 63);
+	n[6] = dn[1];
+	n[7] = (dn[1] >> 1) | (dn[2] << 63);
+
+	ull s0, c0, s1, c1;
+	full_add(n[0], n[1], n[2], &s0, &c0);
+	full_add(n[3], n[4], n[5], &s1, &c1);
+	ull s2 = n[6] ^ n[7];
+	ull c2 = n[6] & n[7];
+
+	// Only the carry of the low bits matters for the >= 4 test
+	ull c3 = (s0 & s1) | (s2 & (s0 ^ s1));
+
+	ull ge4 = (c0 & c1) | (c2 & c3) | ((c0 | c1) & (c2 | c3));
+	return mid[1] & ~ge4;
+}
+
+static ll bitgrid_count_accessible(const BitGrid *g) {
+	ll total = 0;
+	for (int r = 0; r < g->rows; ++r) {
+		for (int w = 0; w < g->words; ++w) total += __builtin_popcountll(bitgrid_accessible_word(g, r, w));
+	}
+	return total;
+}
+
+// Round-synchronous removal on packed rows: every round computes all
+// removal masks into scratch, then clears them
+static ll bitgrid_rounds(BitGrid *g) {
+	size_t n = (size_t)g->rows * (size_t)g->words;
+	ull *remove = (ull *)calloc(n ? n : 1, sizeof(ull));
+	if (!remove) die("calloc failed");
+
+	ll removed = 0;
+	while (1) {
+		ll round_removed = 0;
+		for (int r = 0; r < g->rows; ++r) {
+			for (int w = 0; w < g->words; ++w) {
+				ull x = bitgrid_accessible_word(g, r, w);
+				remove[(size_t)r * g->words + w] = x;
+				round_removed += __builtin_popcountll(x);
+			}
+		}
+
+		if (round_removed == 0) break;
+
+		for (size_t i = 0; i < n; ++i) g->bits[i] &= ~remove[i];
+		removed += round_removed;
+	}
+
+	free(remove);
+	return removed;
+}
+
+// --- Band-parallel rounds ---
+//
+// Each thread owns a horizontal band of packed rows. A round is two phases
+// split by barriers: compute the band's removal masks (reading one halo row
+// from each neighboring band, which nobody writes during this phase), then
+// clear them and publish the band's count. Counts are double-buffered by
+// round parity so every thread can sum them after the second barrier
+// without racing the next round.
+
+typedef struct {
+	BitGrid *g;
+	pthread_barrier_t *barrier;
+	ll (*counts)[256];         // counts[parity][band]
+	ull *remove;               // shared scratch, one slot per word
+	int band;
+	int bands;
+	int row_from;
+	int row_to;
+	ll removed;                // total, filled in by band 0
+} BandJob;
 
-	int size = (int)m.count;
+static void *band_worker(void *arg) {
+	BandJob *job = arg;
+	BitGrid *g = job->g;
+
+	for (int parity = 0;; parity ^= 1) {
+		ll round_removed = 0;
+		for (int r = job->row_from; r < job->row_to; ++r) {
+			for (int w = 0; w < g->words; ++w) {
+				ull x = bitgrid_accessible_word(g, r, w);
+				job->remove[(size_t)r * g->words + w] = x;
+				round_removed += __builtin_popcountll(x);
+			}
+		}
+
+		pthread_barrier_wait(job->barrier);
+
+		size_t from = (size_t)job->row_from * g->words, to = (size_t)job->row_to * g->words;
+		for (size_t i = from; i < to; ++i) g->bits[i] &= ~job->remove[i];
+		job->counts[parity][job->band] = round_removed;
+
+		pthread_barrier_wait(job->barrier);
+
+		ll total = 0;
+		for (int b = 0; b < job->bands; ++b) total += job->counts[parity][b];
+		if (total == 0) break;
+		job->removed += total;
+	}
+
+	return NULL;
+}
+
+static ll bitgrid_rounds_parallel(BitGrid *g, int threads) {
+	if (threads > g->rows) threads = g->rows;
+	if (threads > 256) threads = 256;
+	if (threads <= 1) return bitgrid_rounds(g);
+
+	ull *remove = (ull *)calloc((size_t)g->rows * (size_t)g->words, sizeof(ull));
+	ll (*counts)[256] = calloc(2, sizeof(*counts));
+	BandJob *jobs = calloc((size_t)threads, sizeof(BandJob));
+	if (!remove || !counts || !jobs) die("calloc failed");
+
+	pthread_barrier_t barrier;
+	pthread_barrier_init(&barrier, NULL, (unsigned)threads);
+
+	for (int t = 0; t < threads; ++t) {
+		jobs[t] = (BandJob){
+			.g = g, .barrier = &barrier, .counts = counts, .remove = remove,
+			.band = t, .bands = threads,
+			.row_from = (int)((ll)g->rows * t / threads),
+			.row_to = (int)((ll)g->rows * (t + 1) / threads),
+		};
+	}
+
+	parallel_run(threads, band_worker, jobs, sizeof(BandJob));
+	ll removed = jobs[0].removed;
+
+	pthread_barrier_destroy(&barrier);
+	free(jobs);
+	free(counts);
+	free(remove);
+
+	return removed;
+}
+
+// --- Streaming part 1 ---
+//
+// Part 1 only looks one row up and down, so rows can be packed as they
+// arrive into a three-row window (above, current, below) and the middle row
+// counted once its lower neighbor is known. Memory is O(width); the width
+// grows if a longer row shows up.
+
+static void window_resize(BitGrid *w, int cols) {
+	int words = (cols + 63) / 64;
+	if (words > w->words) {
+		ull *bits = (ull *)calloc(3 * (size_t)words, sizeof(ull));
+		if (!bits) die("calloc failed");
+		for (int r = 0; r < 3; ++r) {
+			if (w->bits) memcpy(bits + (size_t)r * words, w->bits + (size_t)r * w->words, (size_t)w->words * sizeof(ull));
+		}
+		free(w->bits);
+		w->bits = bits;
+		w->words = words;
+	}
+	if (cols > w->cols) w->cols = cols;
+}
+
+// Shift the window up one row and pack `line` into the bottom slot
+static void window_push(BitGrid *w, const char *line, size_t len) {
+	memmove(w->bits, w->bits + w->words, 2 * (size_t)w->words * sizeof(ull));
+
+	ull *bottom = w->bits + 2 * (size_t)w->words;
+	memset(bottom, 0, (size_t)w->words * sizeof(ull));
+	for (size_t j = 0; j < len; ++j) {
+		if (line[j] == '@') bottom[j / 64] |= 1ULL << (j % 64);
+	}
+}
+
+static ll stream_part1(LineReader *input) {
+	BitGrid w = { .rows = 3 };
 	ll part1 = 0;
-	ll part2 = 0;
+	int seen = 0;
+
+	Span line;
+	while (reader_next_line(input, &line)) {
+		if (line.len == 0) continue;
+		window_resize(&w, (int)line.len);
+		window_push(&w, line.data, line.len);
+
+		// The previous row now has both neighbors
+		if (++seen >= 2) {
+			for (int k = 0; k < w.words; ++k) part1 += __builtin_popcountll(bitgrid_accessible_word(&w, 1, k));
+		}
+	}
+
+	// Last row: its lower neighbor is empty
+	if (seen >= 1) {
+		window_push(&w, "", 0);
+		for (int k = 0; k < w.words; ++k) part1 += __builtin_popcountll(bitgrid_accessible_word(&w, 1, k));
+	}
+
+	free(w.bits);
+	return part1;
+}
+
+// --- Work-queue peeling ---
+//
+// Neighbor counts are computed once. Each round removes its frontier (every
+// '@' with fewer than 4 neighbors), decrements the counts around the removed
+// cells and queues those that just dropped below 4 as the next frontier, so
+// the rounds match the full-grid rescans while total work is O(cells).
+
+typedef struct {
+	int *items;
+	size_t count;
+	size_t capacity;
+} Frontier;
 
-	// PART 1: Count cells with < 4 neighbors
-	for (int i = 0; i < size; ++i) {
-		for (int j = 0; j < size; ++j) {
-			if (m.items[i][j] == '@' && count_neighbors(&m, size, i, j) < 4) {
-				part1++;
+static ll peel_rounds(const Matrix *m, int rows, int cols) {
+	size_t cells = (size_t)rows * (size_t)cols;
+	if (cells == 0) return 0;
+
+	uch *count = (uch *)calloc(cells, 1);
+	uch *queued = (uch *)calloc(cells, 1);
+	if (!count || !queued) die("calloc failed");
+
+	Frontier cur = {0}, next = {0};
+
+	for (int i = 0; i < rows; ++i) {
+		for (int j = 0; j < cols; ++j) {
+			if (m->items[i][j] != '@') continue;
+			int idx = i * cols + j;
+			count[idx] = (uch)count_neighbors(m, rows, cols, i, j);
+			if (count[idx] < 4) {
+				queued[idx] = 1;
+				da_append(&cur, idx);
 			}
 		}
 	}
 
-	// PART 2: Iteratively remove isolated cells
-	while (1) {
-		size_t round_removed = 0;
+	ll removed = 0;
+	while (cur.count > 0) {
+		size_t round_removed = cur.count;
+
+		// Clear the whole frontier first so it is removed simultaneously
+		for (size_t q = 0; q < cur.count; ++q) {
+			int idx = cur.items[q];
+			m->items[idx / cols][idx % cols] = '.';
+		}
 
-		// Use a temporary removal list to avoid modifying while iterating
-		char *to_remove = (char *)malloc(size * size);
-		memset(to_remove, 0, size * size);
+		next.count = 0;
+		for (size_t q = 0; q < cur.count; ++q) {
+			int i = cur.items[q] / cols, j = cur.items[q] % cols;
+			for (int k = 0; k < 8; ++k) {
+				int nr = i + dr[k];
+				int nc = j + dc[k];
+				if (nr < 0 || nr >= rows || nc < 0 || nc >= cols || m->items[nr][nc] != '@') continue;
 
-		for (int i = 0; i < size; ++i) {
-			for (int j = 0; j < size; ++j) {
-				if (m.items[i][j] == '@' && count_neighbors(&m, size, i, j) < 4) {
-					to_remove[i * size + j] = 1;
-					round_removed++;
+				int nidx = nr * cols + nc;
+				if (--count[nidx] < 4 && !queued[nidx]) {
+					queued[nidx] = 1;
+					da_append(&next, nidx);
 				}
 			}
 		}
 
-		if (round_removed == 0) {
-			free(to_remove);
-			break;
+		removed += round_removed;
+		da_swap(cur, next);
+	}
+
+	da_free(&cur);
+	da_free(&next);
+	free(count);
+	free(queued);
+
+	return removed;
+}
+
+// --- Generalized neighborhoods ---
+//
+// For radius r and threshold t a cell is accessible when fewer than t other
+// '@' cells lie in its (2r+1)^2 square. Part 1 reads every square from a
+// summed-area table in O(1). Part 2 keeps occupancy in a 2D Fenwick tree so
+// removals are O(log^2) updates and squares O(log^2) queries; after each
+// round only cells within r of a removed cell are re-checked (or every
+// remaining cell, when that is cheaper).
+
+typedef struct {
+	int rows;
+	int cols;
+	int *tree;         // 1-indexed, (rows + 1) x (cols + 1)
+} Fenwick2D;
+
+static Fenwick2D fenwick_build(const Matrix *m, int rows, int cols) {
+	Fenwick2D f = { .rows = rows, .cols = cols };
+	size_t stride = (size_t)cols + 1;
+	f.tree = (int *)calloc(((size_t)rows + 1) * stride, sizeof(int));
+	if (!f.tree) die("calloc failed");
+
+	for (int i = 0; i < rows; ++i) {
+		for (int j = 0; j < cols; ++j) f.tree[(i + 1) * stride + j + 1] = m->items[i][j] == '@';
+	}
+
+	// Linear-time build: push partial sums to the parent along each axis
+	for (int i = 1; i <= rows; ++i) {
+		for (int j = 1; j <= cols; ++j) {
+			int p = j + (j & -j);
+			if (p <= cols) f.tree[i * stride + p] += f.tree[i * stride + j];
+		}
+	}
+	for (int i = 1; i <= rows; ++i) {
+		int p = i + (i & -i);
+		if (p > rows) continue;
+		for (int j = 1; j <= cols; ++j) f.tree[p * stride + j] += f.tree[i * stride + j];
+	}
+
+	return f;
+}
+
+static inline void fenwick_add(Fenwick2D *f, int r, int c, int delta) {
+	size_t stride = (size_t)f->cols + 1;
+	for (int i = r + 1; i <= f->rows; i += i & -i) {
+		for (int j = c + 1; j <= f->cols; j += j & -j) f->tree[i * stride + j] += delta;
+	}
+}
+
+// Sum over rows [0, r) and columns [0, c)
+static inline int fenwick_prefix(const Fenwick2D *f, int r, int c) {
+	size_t stride = (size_t)f->cols + 1;
+	int sum = 0;
+	for (int i = r; i > 0; i -= i & -i) {
+		for (int j = c; j > 0; j -= j & -j) sum += f->tree[i * stride + j];
+	}
+	return sum;
+}
+
+static inline int clampi(int x, int lo, int hi) { return x < lo ? lo : x > hi ? hi : x; }
+
+// '@' cells in the radius-r square around (i, j), the cell itself included
+static inline int fenwick_square(const Fenwick2D *f, int i, int j, int radius) {
+	int r0 = clampi(i - radius, 0, f->rows), r1 = clampi(i + radius + 1, 0, f->rows);
+	int c0 = clampi(j - radius, 0, f->cols), c1 = clampi(j + radius + 1, 0, f->cols);
+	return fenwick_prefix(f, r1, c1) - fenwick_prefix(f, r0, c1) - fenwick_prefix(f, r1, c0) + fenwick_prefix(f, r0, c0);
+}
+
+static ll sat_count_accessible(const Matrix *m, int rows, int cols, int radius, int threshold) {
+	size_t stride = (size_t)cols + 1;
+	int *sat = (int *)calloc(((size_t)rows + 1) * stride, sizeof(int));
+	if (!sat) die("calloc failed");
+
+	for (int i = 0; i < rows; ++i) {
+		for (int j = 0; j < cols; ++j) {
+			sat[(i + 1) * stride + j + 1] = (m->items[i][j] == '@') + sat[i * stride + j + 1]
+			                              + sat[(i + 1) * stride + j] - sat[i * stride + j];
+		}
+	}
+
+	ll accessible = 0;
+	for (int i = 0; i < rows; ++i) {
+		int r0 = clampi(i - radius, 0, rows), r1 = clampi(i + radius + 1, 0, rows);
+		for (int j = 0; j < cols; ++j) {
+			if (m->items[i][j] != '@') continue;
+			int c0 = clampi(j - radius, 0, cols), c1 = clampi(j + radius + 1, 0, cols);
+			int n = sat[r1 * stride + c1] - sat[r0 * stride + c1] - sat[r1 * stride + c0] + sat[r0 * stride + c0] - 1;
+			if (n < threshold) accessible++;
 		}
+	}
+
+	free(sat);
+	return accessible;
+}
+
+static ll fenwick_peel(Matrix *m, int rows, int cols, int radius, int threshold) {
+	size_t cells = (size_t)rows * (size_t)cols;
+	if (cells == 0) return 0;
+
+	Fenwick2D f = fenwick_build(m, rows, cols);
+	int *stamp = (int *)calloc(cells, sizeof(int));
+	if (!stamp) die("calloc failed");
+
+	Frontier candidates = {0}, removed_now = {0};
+	for (int i = 0; i < rows; ++i) {
+		for (int j = 0; j < cols; ++j) {
+			if (m->items[i][j] == '@') da_append(&candidates, i * cols + j);
+		}
+	}
 
-		// Apply removals
-		for (int i = 0; i < size; ++i) {
-			for (int j = 0; j < size; ++j) {
-				if (to_remove[i * size + j]) {
-					m.items[i][j] = '.';
+	ll remaining = (ll)candidates.count, removed = 0;
+	ll side = 2 * (ll)radius + 1;
+
+	for (int round = 1; candidates.count > 0; ++round) {
+		removed_now.count = 0;
+		for (size_t q = 0; q < candidates.count; ++q) {
+			int idx = candidates.items[q], i = idx / cols, j = idx % cols;
+			if (fenwick_square(&f, i, j, radius) - 1 < threshold) da_append(&removed_now, idx);
+		}
+		if (removed_now.count == 0) break;
+
+		// Remove the whole round at once
+		for (size_t q = 0; q < removed_now.count; ++q) {
+			int idx = removed_now.items[q];
+			m->items[idx / cols][idx % cols] = '.';
+			fenwick_add(&f, idx / cols, idx % cols, -1);
+		}
+		removed += (ll)removed_now.count;
+		remaining -= (ll)removed_now.count;
+
+		// Next candidates: survivors near a removal, or all survivors
+		candidates.count = 0;
+		if ((ll)removed_now.count * side * side >= remaining) {
+			for (int i = 0; i < rows; ++i) {
+				for (int j = 0; j < cols; ++j) {
+					if (m->items[i][j] == '@') da_append(&candidates, i * cols + j);
 				}
 			}
+			continue;
 		}
+		for (size_t q = 0; q < removed_now.count; ++q) {
+			int i = removed_now.items[q] / cols, j = removed_now.items[q] % cols;
+			for (int nr = clampi(i - radius, 0, rows - 1); nr <= clampi(i + radius, 0, rows - 1); ++nr) {
+				for (int nc = clampi(j - radius, 0, cols - 1); nc <= clampi(j + radius, 0, cols - 1); ++nc) {
+					int nidx = nr * cols + nc;
+					if (m->items[nr][nc] != '@' || stamp[nidx] == round) continue;
+					stamp[nidx] = round;
+					da_append(&candidates, nidx);
+				}
+			}
+		}
+	}
+
+	da_free(&candidates);
+	da_free(&removed_now);
+	free(stamp);
+	free(f.tree);
+
+	return removed;
+}
+
+static void usage(const char *prog) {
+	fprintf(stderr, "Usage: %s <input_file> [--packed | --stream | --radius <r> --threshold <t>]\n", prog);
+	exit(EXIT_FAILURE);
+}
 
-		free(to_remove);
-		part2 += round_removed;
+int main(int argc, char **argv) {
+	bool packed_rounds = false, streaming = false;
+	int radius = 1, threshold = 4;
+
+	for (int i = 2; i < argc; ++i) {
+		if (strcmp(argv[i], "--packed") == 0) packed_rounds = true;
+		else if (strcmp(argv[i], "--stream") == 0) streaming = true;
+		else if (strcmp(argv[i], "--radius") == 0 && i + 1 < argc) radius = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) threshold = atoi(argv[++i]);
+		else usage(argv[0]);
 	}
+	bool generalized = radius != 1 || threshold != 4;
+	if (radius < 1 || (generalized && (streaming || packed_rounds))) usage(argv[0]);
+
+	// Part 1 only, with O(width) memory; works on pipes
+	if (streaming) {
+		LineReader input = reader_open_input_or_die(argc, argv);
+		printf("Part1: %lld\n", stream_part1(&input));
+		reader_close(&input);
+		return 0;
+	}
+
+	FILE *input = open_input_or_die(argc, argv);
+	
+	Matrix m = {0};
+	char *line = NULL;
+	size_t len = 0;
+	ssize_t read;
+	int rows = 0, cols = 0;
+
+	while ((read = getline_or_die(&line, &len, input)) != -1) {
+		line[strcspn(line, "\r\n")] = '\0';
+		if (line[0] == '\0') continue;
+		int n = (int)strlen(line);
+		if (n > cols) cols = n;
+		da_append(&m, strdup(line));
+	}
+
+	fclose(input);
+	free(line);
+
+	// Pad ragged rows so every row has `cols` cells
+	rows = (int)m.count;
+	for (int i = 0; i < rows; ++i) {
+		size_t cur = strlen(m.items[i]);
+		if (cur < (size_t)cols) {
+			m.items[i] = (char *)realloc(m.items[i], (size_t)cols + 1);
+			if (!m.items[i]) die("realloc failed");
+			memset(m.items[i] + cur, '.', (size_t)cols - cur);
+			m.items[i][cols] = '\0';
+		}
+	}
+
+	ll part1 = 0;
+	ll part2 = 0;
+
+	// Other radii/thresholds: summed-area table and Fenwick peeling
+	if (generalized) {
+		printf("Part1: %lld\n", sat_count_accessible(&m, rows, cols, radius, threshold));
+		printf("Part2: %lld\n", fenwick_peel(&m, rows, cols, radius, threshold));
+		da_free_deep(&m);
+		return 0;
+	}
+
+	// PART 1: Count cells with < 4 neighbors, 64 at a time
+	BitGrid g = bitgrid_from_matrix(&m, rows, cols);
+	part1 = bitgrid_count_accessible(&g);
+
+	// PART 2: Iteratively remove isolated cells; queue peeling by default,
+	// band-parallel packed rounds on request
+	if (packed_rounds) part2 = bitgrid_rounds_parallel(&g, parallel_threads());
+	else part2 = peel_rounds(&m, rows, cols);
 
 	printf("Part1: %lld\n", part1);
 	printf("Part2: %lld\n", part2);
 
 	da_free_deep(&m);
+	free(g.bits);
 
 	return 0;
 }
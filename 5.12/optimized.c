@@ -1,4 +1,8 @@
+#define MMAP_IMPLEMENTATION
+#define STREAM_IMPLEMENTATION
+#define PARALLEL_IMPLEMENTATION
 #include "../nob.h"
+#include <math.h>
 
 typedef struct {
 	ll left;
@@ -29,96 +33,972 @@ static inline int compare_ranges(const void *a, const void *b) {
 	return (diff > 0) - (diff < 0);
 }
 
-// Binary search with early termination
-static inline bool is_in_range(const Range *arr, size_t len, ll id) {
-	ssize_t l = 0, r = (ssize_t)len - 1;
-	while (l <= r) {
-		size_t mid = (size_t)(l + (r - l) / 2);
-		if (arr[mid].left <= id && id <= arr[mid].right) {
-			return true;
+// Parse an unsigned decimal at *p, advancing it; false if no digits
+static inline bool parse_ll_span(const char **p, const char *end, ll *out) {
+	const char *q = *p;
+	ll v = 0;
+	while (q < end && *q >= '0' && *q <= '9') v = v * 10 + (*q++ - '0');
+	if (q == *p) return false;
+	*p = q;
+	*out = v;
+	return true;
+}
+
+// --- Eytzinger range index ---
+//
+// The merged left bounds in BFS (Eytzinger) order, padded with LLONG_MAX to
+// a complete tree so every search takes exactly `depth` steps. A step reads
+// one node and picks a child branch-free; the 16 nodes four levels below
+// share a cache line and are prefetched. Batches of queries advance in
+// lock-step, so their cache misses overlap instead of serializing.
+
+#define INDEX_BATCH 16
+
+typedef struct {
+	ll *keys;          // 1-indexed, keys[k] for k in [1, size]
+	uint *rank;        // rank[k]: position of keys[k] in sorted order
+	size_t size;       // 2^depth - 1
+	int depth;
+	const Ranges *merged;
+} RangeIndex;
+
+static void range_index_fill(RangeIndex *idx, const ll *lefts, size_t n, size_t *next, size_t k) {
+	if (k > idx->size) return;
+	range_index_fill(idx, lefts, n, next, 2 * k);
+	idx->keys[k] = *next < n ? lefts[*next] : LLONG_MAX;
+	idx->rank[k] = (uint)*next;
+	(*next)++;
+	range_index_fill(idx, lefts, n, next, 2 * k + 1);
+}
+
+static RangeIndex range_index_build(const Ranges *merged) {
+	RangeIndex idx = { .merged = merged };
+	while (idx.size < merged->count) {
+		idx.depth++;
+		idx.size = 2 * idx.size + 1;
+	}
+
+	// Aligned so that the 16 keys of a subtree level share one cache line
+	idx.keys = aligned_alloc(64, ((idx.size + 1) * sizeof(ll) + 63) / 64 * 64);
+	idx.rank = xmalloc((idx.size + 1) * sizeof(uint));
+	if (!idx.keys) die("aligned_alloc failed");
+
+	ll *lefts = xmalloc((merged->count + 1) * sizeof(ll));
+	for (size_t i = 0; i < merged->count; ++i) lefts[i] = merged->items[i].left;
+
+	size_t next = 0;
+	range_index_fill(&idx, lefts, merged->count, &next, 1);
+	free(lefts);
+
+	return idx;
+}
+
+static void range_index_free(RangeIndex *idx) {
+	free(idx->keys);
+	free(idx->rank);
+}
+
+// Node k reached after `depth` steps -> is id inside a merged range?
+static inline bool range_index_resolve(const RangeIndex *idx, size_t k, ll id) {
+	// Undo the trailing right turns: k becomes the first key > id (0: none)
+	k >>= __builtin_ffsll((ll)~k);
+	size_t above = k ? idx->rank[k] : idx->merged->count;
+	if (above > idx->merged->count) above = idx->merged->count;
+	if (above == 0) return false;
+	return id <= idx->merged->items[above - 1].right;
+}
+
+static inline bool range_index_contains(const RangeIndex *idx, ll id) {
+	size_t k = 1;
+	for (int level = 0; level < idx->depth; ++level) {
+		__builtin_prefetch(idx->keys + 16 * k);
+		k = 2 * k + (idx->keys[k] <= id);
+	}
+	return range_index_resolve(idx, k, id);
+}
+
+// Count members among ids, INDEX_BATCH interleaved lookups at a time
+static ll range_index_count(const RangeIndex *idx, const ll *ids, size_t n) {
+	ll count = 0;
+	size_t i = 0;
+
+	for (; i + INDEX_BATCH <= n; i += INDEX_BATCH) {
+		size_t k[INDEX_BATCH];
+		for (int l = 0; l < INDEX_BATCH; ++l) k[l] = 1;
+
+		for (int level = 0; level < idx->depth; ++level) {
+			for (int l = 0; l < INDEX_BATCH; ++l) {
+				__builtin_prefetch(idx->keys + 16 * k[l]);
+				k[l] = 2 * k[l] + (idx->keys[k[l]] <= ids[i + l]);
+			}
 		}
-		if (id < arr[mid].left) {
-			r = (ssize_t)mid - 1;
+
+		for (int l = 0; l < INDEX_BATCH; ++l) count += range_index_resolve(idx, k[l], ids[i + l]);
+	}
+
+	for (; i < n; ++i) count += range_index_contains(idx, ids[i]);
+	return count;
+}
+
+static ll count_by_search(const Ranges *merged, const ll *ids, size_t n) {
+	RangeIndex idx = range_index_build(merged);
+	ll count = range_index_count(&idx, ids, n);
+	range_index_free(&idx);
+	return count;
+}
+
+// Both sides sorted: one linear pass with two pointers
+static ll count_merge_join(const Ranges *merged, const ll *ids, size_t n) {
+	const Range *r = merged->items;
+	size_t nr = merged->count, j = 0;
+	ll count = 0;
+
+	for (size_t i = 0; i < n; ++i) {
+		ll id = ids[i];
+		while (j < nr && r[j].right < id) j++;
+		if (j == nr) break;
+		count += r[j].left <= id;
+	}
+
+	return count;
+}
+
+static bool is_sorted_ll(const ll *a, size_t n) {
+	for (size_t i = 1; i < n; ++i) {
+		if (a[i] < a[i - 1]) return false;
+	}
+	return true;
+}
+
+// Sort-then-join costs about E log E + E + R, searching about E log R:
+// pick the cheaper one unless the IDs already arrive sorted
+static ll count_members(const Ranges *merged, LLDA *elements) {
+	size_t e = elements->count, r = merged->count;
+
+	if (!is_sorted_ll(elements->items, e)) {
+		double join_cost = (double)e * log2((double)e + 1) + (double)e + (double)r;
+		double search_cost = (double)e * log2((double)r + 1);
+		if (search_cost < join_cost) return count_by_search(merged, elements->items, e);
+
+		qsort(elements->items, e, sizeof(ll), compare_ll);
+	}
+
+	return count_merge_join(merged, elements->items, e);
+}
+
+// --- Parallel sort and merge ---
+//
+// For large inputs the qsorts and the serial merge dominate. IDs and ranges
+// are radix sorted 8 bits per pass (each pass: per-thread histograms, one
+// shared prefix sum, per-thread scatter; passes where every key has the same
+// digit are skipped). Sorted range chunks are then merged locally by each
+// thread and stitched together with a serial boundary fixup, and part 1 and
+// part 2 are counted and summed per chunk.
+
+#define PARALLEL_MIN_ITEMS (1 << 20)
+#define RADIX_BUCKETS 256
+
+typedef struct {
+	const void *src;
+	void *dst;
+	size_t size;               // sizeof(ll) for IDs, sizeof(Range) for ranges
+	size_t begin;
+	size_t end;
+	int shift;
+	size_t hist[RADIX_BUCKETS]; // digit counts, then scatter positions
+} RadixJob;
+
+// Sign bit flipped so that negative keys order first
+static inline size_t radix_digit(ll key, int shift) {
+	return (size_t)((((ull)key ^ (1ull << 63)) >> shift) & (RADIX_BUCKETS - 1));
+}
+
+static void *radix_histogram(void *arg) {
+	RadixJob *job = arg;
+	memset(job->hist, 0, sizeof(job->hist));
+
+	if (job->size == sizeof(ll)) {
+		const ll *src = job->src;
+		for (size_t i = job->begin; i < job->end; ++i) job->hist[radix_digit(src[i], job->shift)]++;
+	} else {
+		const Range *src = job->src;
+		for (size_t i = job->begin; i < job->end; ++i) job->hist[radix_digit(src[i].left, job->shift)]++;
+	}
+	return NULL;
+}
+
+static void *radix_scatter(void *arg) {
+	RadixJob *job = arg;
+
+	if (job->size == sizeof(ll)) {
+		const ll *src = job->src;
+		ll *dst = job->dst;
+		for (size_t i = job->begin; i < job->end; ++i) dst[job->hist[radix_digit(src[i], job->shift)]++] = src[i];
+	} else {
+		const Range *src = job->src;
+		Range *dst = job->dst;
+		for (size_t i = job->begin; i < job->end; ++i) dst[job->hist[radix_digit(src[i].left, job->shift)]++] = src[i];
+	}
+	return NULL;
+}
+
+// Stable LSD sort of n IDs or ranges (by left), keyed on the leading ll
+static void radix_sort_parallel(void *items, size_t n, size_t size, int threads) {
+	if (n < 2) return;
+
+	RadixJob *jobs = xmalloc((size_t)threads * sizeof(RadixJob));
+	void *tmp = xmalloc(n * size);
+	void *src = items, *dst = tmp;
+
+	for (int t = 0; t < threads; ++t) {
+		jobs[t].size = size;
+		jobs[t].begin = n * (size_t)t / (size_t)threads;
+		jobs[t].end = n * (size_t)(t + 1) / (size_t)threads;
+	}
+
+	for (int shift = 0; shift < 64; shift += 8) {
+		for (int t = 0; t < threads; ++t) {
+			jobs[t].src = src;
+			jobs[t].dst = dst;
+			jobs[t].shift = shift;
+		}
+		parallel_run(threads, radix_histogram, jobs, sizeof(RadixJob));
+
+		// Bucket-major, thread-minor offsets keep the sort stable
+		size_t pos = 0;
+		bool trivial = false;
+		for (int b = 0; b < RADIX_BUCKETS; ++b) {
+			size_t start = pos;
+			for (int t = 0; t < threads; ++t) {
+				size_t c = jobs[t].hist[b];
+				jobs[t].hist[b] = pos;
+				pos += c;
+			}
+			if (pos - start == n) trivial = true;
+		}
+		if (trivial) continue;
+
+		parallel_run(threads, radix_scatter, jobs, sizeof(RadixJob));
+		void *swap = src;
+		src = dst;
+		dst = swap;
+	}
+
+	if (src != items) memcpy(items, src, n * size);
+	free(tmp);
+	free(jobs);
+}
+
+typedef struct {
+	Range *items;
+	size_t begin;
+	size_t end;
+	size_t count;              // merged ranges left at items[begin..]
+	ll sum;
+} MergeJob;
+
+// Merge a sorted chunk in place
+static void *merge_chunk(void *arg) {
+	MergeJob *job = arg;
+	Range *r = job->items + job->begin;
+	size_t n = job->end - job->begin, k = 0;
+
+	for (size_t i = 0; i < n; ++i) {
+		if (k > 0 && r[i].left <= r[k - 1].right + 1) {
+			if (r[i].right > r[k - 1].right) r[k - 1].right = r[i].right;
+		} else {
+			r[k++] = r[i];
+		}
+	}
+
+	job->count = k;
+	return NULL;
+}
+
+static void *sum_chunk(void *arg) {
+	MergeJob *job = arg;
+	ll sum = 0;
+	for (size_t i = job->begin; i < job->end; ++i) sum += job->items[i].right - job->items[i].left + 1;
+	job->sum = sum;
+	return NULL;
+}
+
+// Sort and merge `ranges` (clobbering it) into `merged`; returns part 2
+static ll merge_ranges_parallel(Ranges *ranges, Ranges *merged, int threads) {
+	size_t n = ranges->count;
+	radix_sort_parallel(ranges->items, n, sizeof(Range), threads);
+
+	MergeJob *jobs = xmalloc((size_t)threads * sizeof(MergeJob));
+	for (int t = 0; t < threads; ++t) {
+		jobs[t] = (MergeJob){ .items = ranges->items, .begin = n * (size_t)t / (size_t)threads, .end = n * (size_t)(t + 1) / (size_t)threads };
+	}
+	parallel_run(threads, merge_chunk, jobs, sizeof(MergeJob));
+
+	// Boundary fixup: a chunk's first ranges may still touch its predecessor
+	merged->count = 0;
+	for (int t = 0; t < threads; ++t) {
+		const Range *r = ranges->items + jobs[t].begin;
+		for (size_t i = 0; i < jobs[t].count; ++i) {
+			Range *last = merged->count ? &merged->items[merged->count - 1] : NULL;
+			if (last && r[i].left <= last->right + 1) {
+				if (r[i].right > last->right) last->right = r[i].right;
+			} else {
+				da_append(merged, r[i]);
+			}
+		}
+	}
+
+	for (int t = 0; t < threads; ++t) {
+		jobs[t] = (MergeJob){ .items = merged->items, .begin = merged->count * (size_t)t / (size_t)threads, .end = merged->count * (size_t)(t + 1) / (size_t)threads };
+	}
+	parallel_run(threads, sum_chunk, jobs, sizeof(MergeJob));
+
+	ll part2 = 0;
+	for (int t = 0; t < threads; ++t) part2 += jobs[t].sum;
+
+	free(jobs);
+	return part2;
+}
+
+typedef struct {
+	const Ranges *merged;
+	const ll *ids;
+	size_t n;
+	ll count;
+} CountJob;
+
+// Merge-join one slice of sorted IDs, starting at the first range that can
+// hold its smallest ID
+static void *count_chunk(void *arg) {
+	CountJob *job = arg;
+	if (job->n == 0) return NULL;
+
+	size_t lo = 0, hi = job->merged->count;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (job->merged->items[mid].right < job->ids[0]) lo = mid + 1;
+		else hi = mid;
+	}
+
+	Ranges tail = { .items = job->merged->items + lo, .count = job->merged->count - lo };
+	job->count = count_merge_join(&tail, job->ids, job->n);
+	return NULL;
+}
+
+static ll count_members_parallel(const Ranges *merged, LLDA *elements, int threads) {
+	size_t n = elements->count;
+	if (!is_sorted_ll(elements->items, n)) radix_sort_parallel(elements->items, n, sizeof(ll), threads);
+
+	CountJob *jobs = xmalloc((size_t)threads * sizeof(CountJob));
+	for (int t = 0; t < threads; ++t) {
+		size_t begin = n * (size_t)t / (size_t)threads, end = n * (size_t)(t + 1) / (size_t)threads;
+		jobs[t] = (CountJob){ .merged = merged, .ids = elements->items + begin, .n = end - begin };
+	}
+	parallel_run(threads, count_chunk, jobs, sizeof(CountJob));
+
+	ll count = 0;
+	for (int t = 0; t < threads; ++t) count += jobs[t].count;
+
+	free(jobs);
+	return count;
+}
+
+// --- Compressed bitmap backend ---
+//
+// When the merged ranges are dense and lie below 2^32, they are stored as a
+// roaring-style bitmap: the high 16 bits of an ID select a container, the
+// low 16 bits are looked up inside it. A container holds sorted runs, or a
+// 2^16-bit bitmap once it has more runs than the bitmap is worth, and keeps
+// its cardinality, so part 2 is a sum over containers. When most containers
+// hold runs the IDs are sorted first, so each container is visited once
+// with its whole block of IDs: four bitmap lookups at a time with AVX2
+// gathers where available, or one walk over the runs.
+
+#define ROARING_MAX_RUNS 2048         // 2048 runs * 4 bytes == 8 KiB bitmap
+#define ROARING_MIN_RUNS 16           // average runs per container to choose it
+#define ROARING_MIN_RANGES (1 << 17)  // below this the range search stays in cache
+#define ROARING_WORDS (65536 / 64)
+
+typedef struct {
+	unsigned short start;
+	unsigned short last;             // inclusive
+} Run;
+
+typedef struct {
+	uint key;                        // high 16 bits
+	uint cardinality;
+	Run *items;                      // run container, or NULL
+	size_t count;
+	size_t capacity;
+	ull *bits;                       // bitmap container, or NULL
+} Container;
+
+typedef struct {
+	Container *items;
+	size_t count;
+	size_t capacity;
+	uint *slot;                      // slot[key]: container index + 1, 0 if none
+} Roaring;
+
+static void container_to_bitmap(Container *c) {
+	c->bits = calloc(ROARING_WORDS, sizeof(ull));
+	if (!c->bits) die("calloc failed");
+
+	for (size_t i = 0; i < c->count; ++i) {
+		uint lo = c->items[i].start, hi = c->items[i].last;
+		uint wlo = lo >> 6, whi = hi >> 6;
+		ull first = ~0ull << (lo & 63), final = ~0ull >> (63 - (hi & 63));
+
+		if (wlo == whi) {
+			c->bits[wlo] |= first & final;
 		} else {
-			l = (ssize_t)mid + 1;
+			c->bits[wlo] |= first;
+			for (uint w = wlo + 1; w < whi; ++w) c->bits[w] = ~0ull;
+			c->bits[whi] |= final;
 		}
 	}
-	return false;
+
+	da_free(c);
+	c->items = NULL;
+	c->count = c->capacity = 0;
+}
+
+// Merged ranges must be sorted, disjoint and below 2^32
+static Roaring roaring_build(const Ranges *merged) {
+	Roaring rb = {0};
+
+	for (size_t i = 0; i < merged->count; ++i) {
+		ll left = merged->items[i].left, right = merged->items[i].right;
+
+		// One run per container the range touches
+		while (left <= right) {
+			uint key = (uint)(left >> 16);
+			ll end = ((ll)key << 16) | 0xFFFF;
+			if (end > right) end = right;
+
+			if (rb.count == 0 || da_last(&rb).key != key) {
+				if (rb.count > 0 && da_last(&rb).count > ROARING_MAX_RUNS) container_to_bitmap(&da_last(&rb));
+				da_append(&rb, ((Container){ .key = key }));
+			}
+
+			Container *c = &da_last(&rb);
+			da_append(c, ((Run){ .start = (unsigned short)left, .last = (unsigned short)end }));
+			c->cardinality += (uint)(end - left + 1);
+			left = end + 1;
+		}
+	}
+	if (rb.count > 0 && da_last(&rb).count > ROARING_MAX_RUNS) container_to_bitmap(&da_last(&rb));
+
+	rb.slot = calloc(65536, sizeof(uint));
+	if (!rb.slot) die("calloc failed");
+	for (size_t i = 0; i < rb.count; ++i) rb.slot[rb.items[i].key] = (uint)i + 1;
+
+	return rb;
+}
+
+static void roaring_free(Roaring *rb) {
+	for (size_t i = 0; i < rb->count; ++i) {
+		free(rb->items[i].items);
+		free(rb->items[i].bits);
+	}
+	free(rb->slot);
+	da_free(rb);
+}
+
+static ll roaring_cardinality(const Roaring *rb) {
+	ll total = 0;
+	for (size_t i = 0; i < rb->count; ++i) total += rb->items[i].cardinality;
+	return total;
+}
+
+static inline const Container *roaring_find(const Roaring *rb, uint key) {
+	uint slot = rb->slot[key];
+	return slot ? &rb->items[slot - 1] : NULL;
+}
+
+static inline bool bitmap_test(const ull *bits, ll id) {
+	uint low = (uint)id & 0xFFFF;
+	return (bits[low >> 6] >> (low & 63)) & 1;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+static bool use_avx2;
+
+__attribute__((target("avx2")))
+static ll bitmap_count_avx2(const ull *bits, const ll *ids, size_t n) {
+	const __m256i low_mask = _mm256_set1_epi64x(0xFFFF);
+	const __m256i bit_mask = _mm256_set1_epi64x(63);
+	__m256i acc = _mm256_setzero_si256();
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		__m256i low = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(ids + i)), low_mask);
+		__m256i word = _mm256_i64gather_epi64((const long long *)bits, _mm256_srli_epi64(low, 6), 8);
+		__m256i bit = _mm256_srlv_epi64(word, _mm256_and_si256(low, bit_mask));
+		acc = _mm256_add_epi64(acc, _mm256_and_si256(bit, _mm256_set1_epi64x(1)));
+	}
+
+	ll lanes[4];
+	_mm256_storeu_si256((__m256i *)lanes, acc);
+	ll count = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+
+	for (; i < n; ++i) count += bitmap_test(bits, ids[i]);
+	return count;
+}
+#endif
+
+// First run of c that ends at or after low
+static inline size_t run_search(const Container *c, unsigned short low) {
+	size_t lo = 0, hi = c->count;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (c->items[mid].last < low) lo = mid + 1;
+		else hi = mid;
+	}
+	return lo;
+}
+
+// Count members among ids that all fall into container c
+static ll container_count(const Container *c, const ll *ids, size_t n) {
+	ll count = 0;
+
+	if (c->bits) {
+#if defined(__x86_64__) || defined(__i386__)
+		if (use_avx2 && n >= 4) return bitmap_count_avx2(c->bits, ids, n);
+#endif
+		for (size_t i = 0; i < n; ++i) count += bitmap_test(c->bits, ids[i]);
+		return count;
+	}
+
+	// Walk runs and IDs together, searching again whenever the IDs step back
+	size_t run = 0;
+	unsigned short prev = 0;
+	for (size_t i = 0; i < n; ++i) {
+		unsigned short low = (unsigned short)(ids[i] & 0xFFFF);
+		if (i == 0 || low < prev) run = run_search(c, low);
+		while (run < c->count && c->items[run].last < low) run++;
+		count += run < c->count && c->items[run].start <= low;
+		prev = low;
+	}
+	return count;
+}
+
+// Run containers answer sorted blocks with one walk, bitmaps answer any ID
+// in O(1); sorting the IDs only pays when runs are the common case
+static bool roaring_mostly_runs(const Roaring *rb) {
+	size_t runs = 0;
+	for (size_t i = 0; i < rb->count; ++i) runs += !rb->items[i].bits;
+	return 2 * runs > rb->count;
+}
+
+static ll roaring_count(const Roaring *rb, const ll *ids, size_t n) {
+	ll count = 0;
+	size_t i = 0;
+
+	while (i < n) {
+		ll key = ids[i] >> 16;
+
+		// Block of consecutive IDs sharing the container
+		size_t j = i + 1;
+		while (j < n && ids[j] >> 16 == key) j++;
+
+		if (key >= 0 && key <= 0xFFFF) {
+			const Container *c = roaring_find(rb, (uint)key);
+			if (c) count += container_count(c, ids + i, j - i);
+		}
+		i = j;
+	}
+
+	return count;
+}
+
+// The IDs usually get radix sorted, which costs about as much per ID as a
+// search over a cache-resident Eytzinger index, and sorted IDs already get
+// a linear merge join. So the bitmap is only chosen for unsorted IDs against
+// at least ROARING_MIN_RANGES ranges, whose index no longer fits in cache,
+// and only when containers are dense: at least ROARING_MIN_RUNS runs on
+// average (bitmaps past ROARING_MAX_RUNS), with enough IDs to repay the build
+static bool roaring_pays_off(const Ranges *merged, const LLDA *elements) {
+	size_t r = merged->count, e = elements->count;
+	if (r < ROARING_MIN_RANGES || e < r || merged->items[r - 1].right > (ll)UINT_MAX) return false;
+	if (is_sorted_ll(elements->items, e)) return false;
+
+	size_t containers = 0;
+	ll last_key = -1;
+	for (size_t i = 0; i < r; ++i) {
+		ll lo = merged->items[i].left >> 16, hi = merged->items[i].right >> 16;
+		containers += (size_t)(hi - lo + 1) - (lo == last_key);
+		last_key = hi;
+	}
+
+	return r >= ROARING_MIN_RUNS * containers;
+}
+
+// --- Persistent index file ---
+//
+// `--build-index <file>` stores the merged, sorted ranges and the part 2
+// total; `--index <file>` maps that file instead of parsing, sorting and
+// merging, so a run only has to read its IDs. Layout: IndexHeader followed
+// by `count` Range records, native endianness.
+
+#define INDEX_MAGIC "AOC5IDX"
+#define INDEX_VERSION 1
+
+typedef struct {
+	char magic[8];
+	uint version;
+	uint range_size;   // sizeof(Range), guards against layout changes
+	ull count;
+	ll part2;
+} IndexHeader;
+
+static void index_write_or_die(const char *path, const Ranges *merged, ll part2) {
+	FILE *f = fopen(path, "wb");
+	if (!f) die("Error creating index file");
+
+	IndexHeader h = { .version = INDEX_VERSION, .range_size = sizeof(Range), .count = merged->count, .part2 = part2 };
+	memcpy(h.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+
+	if (fwrite(&h, sizeof(h), 1, f) != 1
+	    || fwrite(merged->items, sizeof(Range), merged->count, f) != merged->count
+	    || fclose(f) != 0) {
+		die("Error writing index file");
+	}
+}
+
+// Map an index file; *merged then points into the mapping
+static Span index_map_or_die(const char *path, Ranges *merged, ll *part2) {
+	char *args[2] = { NULL, (char *)path };
+	Span map = map_input_or_die(2, args);
+
+	const IndexHeader *h = (const IndexHeader *)map.data;
+	if (map.len < sizeof(IndexHeader) || memcmp(h->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0
+	    || h->version != INDEX_VERSION || h->range_size != sizeof(Range)
+	    || map.len != sizeof(IndexHeader) + h->count * sizeof(Range)) {
+		fprintf(stderr, "Error: '%s' is not a valid version %d index file.\n", path, INDEX_VERSION);
+		exit(1);
+	}
+
+	*merged = (Ranges){ .items = (Range *)(map.data + sizeof(IndexHeader)), .count = h->count };
+	*part2 = h->part2;
+	return map;
+}
+
+// --- Dynamic interval set ---
+//
+// A treap of disjoint, non-adjacent intervals keyed by left bound, each node
+// carrying the covered length of its subtree. Insert and delete split out
+// the affected key range, patch the partially covered intervals at its
+// edges and merge back, so updates, "is x covered" and the part 2 total are
+// all O(log R) expected.
+
+typedef struct IntervalNode {
+	ll left;
+	ll right;
+	ll sum;                    // covered length of this subtree
+	uint prio;
+	struct IntervalNode *l;
+	struct IntervalNode *r;
+} IntervalNode;
+
+typedef struct {
+	IntervalNode *root;
+	uint seed;
+} IntervalSet;
+
+static IntervalNode *interval_node(IntervalSet *set, ll left, ll right) {
+	IntervalNode *n = xmalloc(sizeof(IntervalNode));
+	set->seed ^= set->seed << 13;
+	set->seed ^= set->seed >> 17;
+	set->seed ^= set->seed << 5;
+	*n = (IntervalNode){ .left = left, .right = right, .sum = right - left + 1, .prio = set->seed };
+	return n;
+}
+
+static inline ll interval_sum(const IntervalNode *n) { return n ? n->sum : 0; }
+
+static inline IntervalNode *interval_pull(IntervalNode *n) {
+	n->sum = n->right - n->left + 1 + interval_sum(n->l) + interval_sum(n->r);
+	return n;
+}
+
+// Split into nodes with left < key and left >= key
+static void interval_split(IntervalNode *t, ll key, IntervalNode **lo, IntervalNode **hi) {
+	if (!t) { *lo = *hi = NULL; return; }
+	if (t->left < key) {
+		interval_split(t->r, key, &t->r, hi);
+		*lo = interval_pull(t);
+	} else {
+		interval_split(t->l, key, lo, &t->l);
+		*hi = interval_pull(t);
+	}
+}
+
+// Every key in a precedes every key in b
+static IntervalNode *interval_merge(IntervalNode *a, IntervalNode *b) {
+	if (!a) return b;
+	if (!b) return a;
+	if (a->prio > b->prio) {
+		a->r = interval_merge(a->r, b);
+		return interval_pull(a);
+	}
+	b->l = interval_merge(a, b->l);
+	return interval_pull(b);
+}
+
+// Detach the interval with the largest left bound
+static IntervalNode *interval_pop_max(IntervalNode **t) {
+	if (!*t) return NULL;
+	if (!(*t)->r) {
+		IntervalNode *n = *t;
+		*t = n->l;
+		n->l = NULL;
+		return interval_pull(n);
+	}
+	IntervalNode *n = interval_pop_max(&(*t)->r);
+	interval_pull(*t);
+	return n;
+}
+
+static void interval_free(IntervalNode *t) {
+	if (!t) return;
+	interval_free(t->l);
+	interval_free(t->r);
+	free(t);
+}
+
+// Mark [a, b] as covered, merging with overlapping or adjacent intervals
+static void interval_insert(IntervalSet *set, ll a, ll b) {
+	if (a > b) return;
+
+	IntervalNode *lo, *mid, *hi;
+	interval_split(set->root, a, &lo, &hi);
+
+	IntervalNode *prev = interval_pop_max(&lo);
+	if (prev && prev->right >= a - 1) {
+		a = prev->left;
+		if (prev->right > b) b = prev->right;
+		free(prev);
+	} else if (prev) {
+		lo = interval_merge(lo, prev);
+	}
+
+	// Everything starting in [a, b + 1] is absorbed
+	if (b >= LLONG_MAX - 1) { mid = hi; hi = NULL; }
+	else interval_split(hi, b + 2, &mid, &hi);
+	IntervalNode *last = interval_pop_max(&mid);
+	if (last && last->right > b) b = last->right;
+	free(last);
+	interval_free(mid);
+
+	set->root = interval_merge(interval_merge(lo, interval_node(set, a, b)), hi);
+}
+
+// Mark [a, b] as not covered, splitting intervals that straddle its ends
+static void interval_delete(IntervalSet *set, ll a, ll b) {
+	if (a > b) return;
+
+	IntervalNode *lo, *mid, *hi;
+	interval_split(set->root, a, &lo, &hi);
+
+	IntervalNode *prev = interval_pop_max(&lo);
+	ll tail_left = 0, tail_right = -1;
+	if (prev && prev->right >= a) {
+		if (prev->right > b) { tail_left = b + 1; tail_right = prev->right; }
+		prev->right = a - 1;
+		interval_pull(prev);
+	}
+	if (prev) lo = interval_merge(lo, prev);
+
+	// Everything starting in [a, b] goes; the last one may stick out past b
+	if (b == LLONG_MAX) { mid = hi; hi = NULL; }
+	else interval_split(hi, b + 1, &mid, &hi);
+	IntervalNode *last = interval_pop_max(&mid);
+	if (last && last->right > b) { tail_left = b + 1; tail_right = last->right; }
+	free(last);
+	interval_free(mid);
+
+	if (tail_left <= tail_right) hi = interval_merge(interval_node(set, tail_left, tail_right), hi);
+	set->root = interval_merge(lo, hi);
+}
+
+static bool interval_covers(const IntervalSet *set, ll x) {
+	const IntervalNode *t = set->root, *best = NULL;
+	while (t) {
+		if (t->left <= x) { best = t; t = t->r; }
+		else t = t->l;
+	}
+	return best && x <= best->right;
+}
+
+static inline ll interval_total(const IntervalSet *set) { return interval_sum(set->root); }
+
+// Apply an update log: "+a-b" inserts, "-a-b" deletes, "?x" prints whether
+// x is covered, "#" prints the covered total
+static void interval_apply_updates(IntervalSet *set, const char *path) {
+	char *args[2] = { NULL, (char *)path };
+	LineReader updates = reader_open_input_or_die(2, args);
+
+	Span line;
+	while (reader_next_line(&updates, &line)) {
+		if (line.len == 0) continue;
+		const char *p = line.data + 1, *end = line.data + line.len;
+		char op = line.data[0];
+		ll a = 0, b = 0;
+
+		if (op == '#') {
+			printf("total: %lld\n", interval_total(set));
+		} else if (op == '?' && parse_ll_span(&p, end, &a)) {
+			printf("%lld: %s\n", a, interval_covers(set, a) ? "fresh" : "spoiled");
+		} else if ((op == '+' || op == '-') && parse_ll_span(&p, end, &a) && p < end && *p++ == '-' && parse_ll_span(&p, end, &b)) {
+			if (op == '+') interval_insert(set, a, b);
+			else interval_delete(set, a, b);
+		} else {
+			fprintf(stderr, "Warning: malformed update '%.*s'.\n", (int)line.len, line.data);
+			exit(1);
+		}
+	}
+
+	reader_close(&updates);
+}
+
+static void usage(const char *prog) {
+	fprintf(stderr, "Usage: %s <input_file> [--build-index <file> | --index <file> | --updates <file>]\n", prog);
+	exit(EXIT_FAILURE);
 }
 
 int main(int argc, char **argv) {
-	FILE *input = open_input_or_die(argc, argv);
+	const char *build_index = NULL, *use_index = NULL, *updates = NULL;
+	if (argc == 4 && strcmp(argv[2], "--build-index") == 0) build_index = argv[3];
+	else if (argc == 4 && strcmp(argv[2], "--index") == 0) use_index = argv[3];
+	else if (argc == 4 && strcmp(argv[2], "--updates") == 0) updates = argv[3];
+	else if (argc != 2) usage(argv[0]);
 
-	char *line = NULL;
-	size_t len = 0;
+	// Regular files are mmapped, pipes are streamed in the background
+	LineReader input = reader_open_input_or_die(argc, argv);
+
+	Span line;
 	bool is_elements = false;
 	
 	Ranges ranges = {0};
 	LLDA elements = {0};
 
-	while (getline(&line, &len, input) != -1) {
-		// Remove trailing newline
-		line[strcspn(line, "\r\n")] = '\0';
-		
+	while (reader_next_line(&input, &line)) {
+		const char *p = line.data, *end = line.data + line.len;
+
 		// Skip empty lines and handle section transition
-		if (strlen(line) == 0) {
+		if (line.len == 0) {
 			is_elements = true;
 			continue;
 		}
 
+		// With a prebuilt index, range lines (if any) are skipped unparsed
+		// and everything else is an ID
+		if (use_index) {
+			if (memchr(line.data, '-', line.len)) continue;
+			is_elements = true;
+		}
+
 		if (!is_elements) {
 			Range r;
-			if (sscanf(line, "%lld-%lld", &r.left, &r.right) != 2) {
-				fprintf(stderr, "Warning: malformed range '%s'.\n", line);
+			if (!parse_ll_span(&p, end, &r.left) || p == end || *p++ != '-' || !parse_ll_span(&p, end, &r.right)) {
+				fprintf(stderr, "Warning: malformed range '%.*s'.\n", (int)line.len, line.data);
 				exit(1);
 			}
 			da_append(&ranges, r);
 		} else {
-			da_append(&elements, atoll(line));
+			ll id = 0;
+			parse_ll_span(&p, end, &id);
+			da_append(&elements, id);
 		}
 	}
 
-	fclose(input);
-	free(line);
-
-	// Sort both arrays
-	qsort(elements.items, elements.count, sizeof(ll), compare_ll);
-	qsort(ranges.items, ranges.count, sizeof(Range), compare_ranges);
+	reader_close(&input);
 
-	// Merge overlapping/adjacent ranges
 	Ranges merged = {0};
-	if (ranges.count > 0) {
-		da_append(&merged, ranges.items[0]);
-		
-		for (size_t i = 1; i < ranges.count; ++i) {
-			const Range *range = &ranges.items[i];
-			Range *last = &merged.items[merged.count - 1];
+	ll part2 = 0;
+	Span index_map = {0};
+
+	// Large inputs sort, merge and count on every core
+	int threads = parallel_threads();
+	bool parallel = threads > 1 && ranges.count + elements.count >= PARALLEL_MIN_ITEMS;
+
+	if (use_index) {
+		index_map = index_map_or_die(use_index, &merged, &part2);
+	} else if (parallel) {
+		part2 = merge_ranges_parallel(&ranges, &merged, threads);
+		if (build_index) index_write_or_die(build_index, &merged, part2);
+	} else {
+		// Sort the ranges; the IDs are sorted only if joining pays off
+		qsort(ranges.items, ranges.count, sizeof(Range), compare_ranges);
+
+		// Merge overlapping/adjacent ranges
+		if (ranges.count > 0) {
+			da_append(&merged, ranges.items[0]);
 			
-			// Check if ranges overlap or are adjacent
-			if (range->left <= last->right + 1) {
-				// Merge: extend right boundary if needed
-				if (range->right > last->right) {
-					last->right = range->right;
+			for (size_t i = 1; i < ranges.count; ++i) {
+				const Range *range = &ranges.items[i];
+				Range *last = &merged.items[merged.count - 1];
+				
+				// Check if ranges overlap or are adjacent
+				if (range->left <= last->right + 1) {
+					// Merge: extend right boundary if needed
+					if (range->right > last->right) {
+						last->right = range->right;
+					}
+				} else {
+					// No overlap, add new range
+					da_append(&merged, *range);
 				}
-			} else {
-				// No overlap, add new range
-				da_append(&merged, *range);
 			}
 		}
-	}
 
-	// Count elements in ranges (Part 1)
-	ll part1 = 0;
-	for (size_t i = 0; i < elements.count; ++i) {
-		if (is_in_range(merged.items, merged.count, elements.items[i])) {
-			part1++;
+		// Sum all range sizes (Part 2)
+		for (size_t i = 0; i < merged.count; ++i) {
+			part2 += merged.items[i].right - merged.items[i].left + 1;
 		}
+
+		if (build_index) index_write_or_die(build_index, &merged, part2);
 	}
 
-	// Sum all range sizes (Part 2)
-	ll part2 = 0;
-	for (size_t i = 0; i < merged.count; ++i) {
-		part2 += merged.items[i].right - merged.items[i].left + 1;
+	// Replay range changes on a mutable set, then answer from it
+	if (updates) {
+		IntervalSet set = { .seed = 2463534242u };
+		for (size_t i = 0; i < merged.count; ++i) interval_insert(&set, merged.items[i].left, merged.items[i].right);
+
+		interval_apply_updates(&set, updates);
+
+		ll fresh = 0;
+		for (size_t i = 0; i < elements.count; ++i) fresh += interval_covers(&set, elements.items[i]);
+
+		printf("part1: %lld\n", fresh);
+		printf("part2: %lld\n", interval_total(&set));
+
+		interval_free(set.root);
+		da_free(&ranges);
+		da_free(&elements);
+		da_free(&merged);
+		return 0;
+	}
+
+	// Count elements in ranges (Part 1)
+	ll part1;
+	if (parallel) {
+		part1 = count_members_parallel(&merged, &elements, threads);
+	} else if (roaring_pays_off(&merged, &elements)) {
+		// Dense universe: bitmap lookups, part 2 from container metadata
+#if defined(__x86_64__) || defined(__i386__)
+		use_avx2 = __builtin_cpu_supports("avx2");
+#endif
+		Roaring rb = roaring_build(&merged);
+		if (roaring_mostly_runs(&rb)) radix_sort_parallel(elements.items, elements.count, sizeof(ll), 1);
+		part1 = roaring_count(&rb, elements.items, elements.count);
+		part2 = roaring_cardinality(&rb);
+		roaring_free(&rb);
+	} else {
+		part1 = count_members(&merged, &elements);
 	}
 
 	printf("part1: %lld\n", part1);
@@ -126,7 +1006,8 @@ int main(int argc, char **argv) {
 
 	da_free(&ranges);
 	da_free(&elements);
-	da_free(&merged);
+	if (use_index) unmap_input(index_map);
+	else da_free(&merged);
 
 	return 0;
 }
@@ -1,13 +1,13 @@
+#define MMAP_IMPLEMENTATION
+#define STREAM_IMPLEMENTATION
 #include "../nob.h"
 
-typedef struct {
-	string *items;
-	size_t count;
-	size_t capacity;
-} LINES;
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 // Optimized parse that handles leading spaces
-static inline ll parse_ll_fast(const string s, size_t len) {
+static inline ll parse_ll_fast(const char *s, size_t len) {
 	ll v = 0;
 	for (size_t i = 0; i < len; ++i) {
 		uch c = (uch)s[i];
@@ -16,47 +16,122 @@ static inline ll parse_ll_fast(const string s, size_t len) {
 	return v;
 }
 
-int main(int argc, char **argv) {
-	FILE *input = open_input_or_die(argc, argv);
-	
-	LINES lines = {0};
-	ll part1 = 0, part2 = 0;
-	string line = NULL;
-	size_t size = 0, rows = 0, cols = 0;
-	ssize_t read = 0;
-
-	// Read input and find max column width
-	while ((read = getline_or_die(&line, &size, input)) != -1) {
-		size_t len = (size_t)read;
-		if (len && line[len - 1] == '\n') line[--len] = '\0';
-		
-		string copy = (string)malloc(len + 1);
-		memcpy(copy, line, len + 1);
-		
-		if (len > cols) cols = len;
-		da_append(&lines, copy);
-		rows++;
+// The worksheet padded to rows x cols in one allocation: `cells` row-major,
+// followed by `columns`, its column-major transpose. Part 1 reads numbers
+// along rows, part 2 reads them down columns, and each gets a layout where
+// its scans are sequential.
+typedef struct {
+	char *cells;           // cells[r * cols + c]
+	char *columns;         // columns[c * rows + r]
+	size_t rows;
+	size_t cols;
+} Worksheet;
+
+#define TRANSPOSE_TILE 64  // a tile writes whole cache lines of each column
+
+#if defined(__SSE2__)
+// 16x16 byte block: four rounds of interleaving row i with row i + 8
+static inline void transpose16_sse2(const char *src, size_t src_stride, char *dst, size_t dst_stride) {
+	__m128i a[16], b[16];
+	for (int i = 0; i < 16; ++i) a[i] = _mm_loadu_si128((const __m128i *)(src + (size_t)i * src_stride));
+
+	for (int round = 0; round < 4; ++round) {
+		for (int i = 0; i < 8; ++i) {
+			b[2 * i] = _mm_unpacklo_epi8(a[i], a[i + 8]);
+			b[2 * i + 1] = _mm_unpackhi_epi8(a[i], a[i + 8]);
+		}
+		memcpy(a, b, sizeof(a));
 	}
-	free(line);
-	fclose(input);
-
-	// Pad all lines to same length
-	for (size_t i = 0; i < rows; ++i) {
-		size_t cur = strlen(lines.items[i]);
-		if (cur < cols) {
-			lines.items[i] = (string)realloc(lines.items[i], cols + 1);
-			memset(lines.items[i] + cur, ' ', cols - cur);
-			lines.items[i][cols] = '\0';
+
+	for (int i = 0; i < 16; ++i) _mm_storeu_si128((__m128i *)(dst + (size_t)i * dst_stride), a[i]);
+}
+#endif
+
+// columns = transpose(cells), tile by tile so both sides stay cache resident
+static void worksheet_transpose(Worksheet *w) {
+	size_t rows = w->rows, cols = w->cols;
+
+	for (size_t r0 = 0; r0 < rows; r0 += TRANSPOSE_TILE) {
+		size_t r1 = r0 + TRANSPOSE_TILE < rows ? r0 + TRANSPOSE_TILE : rows;
+
+		for (size_t c0 = 0; c0 < cols; c0 += TRANSPOSE_TILE) {
+			size_t c1 = c0 + TRANSPOSE_TILE < cols ? c0 + TRANSPOSE_TILE : cols;
+			size_t r = r0;
+
+#if defined(__SSE2__)
+			// Full 16x16 blocks, then the ragged tile edges
+			for (; r + 16 <= r1; r += 16) {
+				size_t c = c0;
+				for (; c + 16 <= c1; c += 16) {
+					transpose16_sse2(w->cells + r * cols + c, cols, w->columns + c * rows + r, rows);
+				}
+				for (size_t cc = c; cc < c1; ++cc) {
+					for (size_t rr = r; rr < r + 16; ++rr) w->columns[cc * rows + rr] = w->cells[rr * cols + cc];
+				}
+			}
+#endif
+			for (size_t cc = c0; cc < c1; ++cc) {
+				for (size_t rr = r; rr < r1; ++rr) w->columns[cc * rows + rr] = w->cells[rr * cols + cc];
+			}
 		}
 	}
+}
 
-	size_t op_row = rows - 1;
-	bool *col_has = (bool *)calloc(cols, sizeof(bool));
+static Worksheet worksheet_load(Span text) {
+	Worksheet w = {0};
+	Span rest = text, line;
+
+	// First pass: shape only
+	while (span_next_line(&rest, &line)) {
+		if (line.len > w.cols) w.cols = line.len;
+		w.rows++;
+	}
+
+	size_t n = w.rows * w.cols;
+	w.cells = xmalloc(2 * n + 1);
+	w.columns = w.cells + n;
+
+	// Second pass: copy and space-pad each row in place
+	rest = text;
+	for (size_t r = 0; span_next_line(&rest, &line); ++r) {
+		char *row = w.cells + r * w.cols;
+		memcpy(row, line.data, line.len);
+		memset(row + line.len, ' ', w.cols - line.len);
+	}
+
+	worksheet_transpose(&w);
+	return w;
+}
+
+int main(int argc, char **argv) {
+	// Regular files are mmapped; pipes are streamed and gathered first
+	LineReader input = reader_open_input_or_die(argc, argv);
+	Bytes piped = {0};
+	Span text = input.map;
+
+	if (input.stream) {
+		Span line;
+		while (reader_next_line(&input, &line)) {
+			da_append_many(&piped, line.data, line.len);
+			da_append(&piped, '\n');
+		}
+		text = (Span){ piped.items, piped.count };
+	}
+
+	Worksheet w = worksheet_load(text);
+	reader_close(&input);
+	da_free(&piped);
+
+	ll part1 = 0, part2 = 0;
+	size_t rows = w.rows, cols = w.cols;
+	size_t op_row = rows ? rows - 1 : 0;
+	bool *col_has = (bool *)calloc(cols + 1, sizeof(bool));
 
 	// Check which columns have data
 	for (size_t c = 0; c < cols; ++c) {
+		const char *column = w.columns + c * rows;
 		for (size_t r = 0; r < op_row; ++r) {
-			if (lines.items[r][c] != ' ') {
+			if (column[r] != ' ') {
 				col_has[c] = true;
 				break;
 			}
@@ -74,10 +149,11 @@ int main(int argc, char **argv) {
 		size_t r = c - 1;
 
 		// Find operator in bottom row
+		const char *ops = w.cells + op_row * cols;
 		char op = '+';
 		for (size_t cc = l; cc <= r; ++cc) {
-			if (lines.items[op_row][cc] != ' ') {
-				op = lines.items[op_row][cc];
+			if (ops[cc] != ' ') {
+				op = ops[cc];
 				break;
 			}
 		}
@@ -88,17 +164,17 @@ int main(int argc, char **argv) {
 
 		for (size_t row = 0; row < op_row; ++row) {
 			size_t len = r - l + 1;
-			const string sub = lines.items[row] + l;
-			
+			const char *sub = w.cells + row * cols + l;
+
 			// Find trimmed bounds
 			size_t trim_start = 0;
 			while (trim_start < len && isspace((uch)sub[trim_start])) trim_start++;
-			
+
 			size_t trim_end = len;
 			while (trim_end > trim_start && isspace((uch)sub[trim_end - 1])) trim_end--;
-			
+
 			if (trim_start < trim_end) {
-				ll v = parse_ll_fast(lines.items[row] + l + trim_start, trim_end - trim_start);
+				ll v = parse_ll_fast(sub + trim_start, trim_end - trim_start);
 				used1 = true;
 				if (op == '+') acc1 += v;
 				else acc1 *= v;
@@ -111,14 +187,15 @@ int main(int argc, char **argv) {
 		bool used2 = false;
 
 		for (size_t cc = r + 1; cc-- > l;) {
+			const char *column = w.columns + cc * rows;
 			ll v = 0;
 			bool found = false;
 
-			// Parse column vertically with early termination
+			// Parse the column top to bottom, now one contiguous run
 			for (size_t row = 0; row < op_row; ++row) {
-				uch c = (uch)lines.items[row][cc];
-				if (c >= '0' && c <= '9') {
-					v = v * 10 + (c - '0');
+				uch ch = (uch)column[row];
+				if (ch >= '0' && ch <= '9') {
+					v = v * 10 + (ch - '0');
 					found = true;
 				}
 			}
@@ -135,7 +212,7 @@ int main(int argc, char **argv) {
 	printf("Part 1: %llu\n", (ull)part1);
 	printf("Part 2: %llu\n", (ull)part2);
 
-	da_free_deep(&lines);
+	free(w.cells);
 	free(col_has);
 
 	return 0;
@@ -105,6 +105,7 @@ typedef long long ll;
 typedef unsigned char uch;
 typedef unsigned int uint;
 typedef unsigned long long ull;
+typedef __int128 i128;
 
 // --- Structs ---
 typedef struct {
@@ -113,6 +114,19 @@ typedef struct {
     uint capacity;
 } DA;
 
+// Byte buffer with size_t bookkeeping, for data that may exceed 4 GiB
+typedef struct {
+    char *items;
+    size_t count;
+    size_t capacity;
+} Bytes;
+
+// Read-only view over a byte buffer (mmapped file, stream buffer or a slice)
+typedef struct {
+    const char *data;
+    size_t len;
+} Span;
+
 // --- Functions --
 static void die(const char *msg) {
     if (msg && *msg) {
@@ -150,6 +164,37 @@ static void *xmalloc(size_t s) {
     return p;
 }
 
+// Format a 128-bit integer into buf (at least 41 bytes); returns buf
+static inline char *i128_to_str(i128 v, char *buf) {
+    char tmp[41];
+    int n = 0;
+    bool neg = v < 0;
+    unsigned __int128 u = neg ? -(unsigned __int128)v : (unsigned __int128)v;
+
+    do { tmp[n++] = (char)('0' + (int)(u % 10)); u /= 10; } while (u);
+    if (neg) tmp[n++] = '-';
+    for (int i = 0; i < n; ++i) buf[i] = tmp[n - 1 - i];
+    buf[n] = '\0';
+
+    return buf;
+}
+
+// Pop the next line (without '\n' / "\r\n") off the front of *rest
+static inline bool span_next_line(Span *rest, Span *line) {
+    if (rest->len == 0) return false;
+
+    const char *nl = memchr(rest->data, '\n', rest->len);
+    size_t n = nl ? (size_t)(nl - rest->data) : rest->len;
+
+    line->data = rest->data;
+    line->len = (n > 0 && rest->data[n - 1] == '\r') ? n - 1 : n;
+
+    size_t adv = nl ? n + 1 : n;
+    rest->data += adv;
+    rest->len -= adv;
+    return true;
+}
+
 // ---
 
 	#ifdef DSU_IMPLEMENTATION
@@ -197,4 +242,531 @@ static void *xmalloc(size_t s) {
 	}
 	
 	#endif // DSU_IMPLEMENTATION
+
+	#ifdef MMAP_IMPLEMENTATION
+
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <errno.h>
+
+	// Map the whole input file read-only; an empty file gives an empty span
+	static Span map_input_or_die(int argc, char **argv) {
+	    if (argc < 2) {
+	        fprintf(stderr, "Error: missing input file.\nUsage: %s <input_file>\n", argv[0]);
+	        exit(EXIT_FAILURE);
+	    }
+
+	    int fd = open(argv[1], O_RDONLY);
+	    if (fd < 0) die("Error opening input file");
+
+	    struct stat st;
+	    if (fstat(fd, &st) < 0) die("fstat failed");
+
+	    Span s = { .data = "", .len = (size_t)st.st_size };
+	    if (s.len > 0) {
+	        void *p = mmap(NULL, s.len, PROT_READ, MAP_PRIVATE, fd, 0);
+	        if (p == MAP_FAILED) die("mmap failed");
+	        madvise(p, s.len, MADV_SEQUENTIAL);
+	        s.data = p;
+	    }
+	    close(fd);
+
+	    return s;
+	}
+
+	static void unmap_input(Span s) {
+	    if (s.len > 0) munmap((void *)s.data, s.len);
+	}
+
+	#endif // MMAP_IMPLEMENTATION
+
+	#ifdef CACHE_IMPLEMENTATION
+
+	#ifndef MMAP_IMPLEMENTATION
+	#error "CACHE_IMPLEMENTATION requires MMAP_IMPLEMENTATION"
+	#endif
+
+	// On-disk result cache: (day, build id, input hash) -> answers.
+	// Opt-in with AOC_CACHE=1. The store is a fixed-size open-addressing
+	// table mmapped from $XDG_CACHE_HOME/aoc2025/results.bin; entries written
+	// by a different binary never match, so rebuilding invalidates them.
+	// Concurrent runs serialize on an flock of the store file.
+
+	#include <sys/file.h>
+
+	typedef struct {
+	    ull lo, hi;
+	} Hash128;
+
+	static inline ull hash_rotl64(ull x, int r) { return (x << r) | (x >> (64 - r)); }
+
+	static inline ull hash_fmix64(ull k) {
+	    k ^= k >> 33;
+	    k *= 0xff51afd7ed558ccdULL;
+	    k ^= k >> 33;
+	    k *= 0xc4ceb9fe1a85ec53ULL;
+	    k ^= k >> 33;
+	    return k;
+	}
+
+	// MurmurHash3 x64_128
+	static Hash128 hash128(const void *data, size_t len, ull seed) {
+	    const uch *p = (const uch *)data;
+	    const ull c1 = 0x87c37b91114253d5ULL, c2 = 0x4cf5ad432745937fULL;
+	    ull h1 = seed, h2 = seed;
+	    size_t nblocks = len / 16;
+
+	    for (size_t i = 0; i < nblocks; ++i) {
+	        ull k1, k2;
+	        memcpy(&k1, p + i * 16, 8);
+	        memcpy(&k2, p + i * 16 + 8, 8);
+
+	        k1 *= c1; k1 = hash_rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+	        h1 = hash_rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+	        k2 *= c2; k2 = hash_rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+	        h2 = hash_rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+	    }
+
+	    const uch *tail = p + nblocks * 16;
+	    ull k1 = 0, k2 = 0;
+	    switch (len & 15) {
+	    case 15: k2 ^= (ull)tail[14] << 48; /* fallthrough */
+	    case 14: k2 ^= (ull)tail[13] << 40; /* fallthrough */
+	    case 13: k2 ^= (ull)tail[12] << 32; /* fallthrough */
+	    case 12: k2 ^= (ull)tail[11] << 24; /* fallthrough */
+	    case 11: k2 ^= (ull)tail[10] << 16; /* fallthrough */
+	    case 10: k2 ^= (ull)tail[9] << 8;   /* fallthrough */
+	    case 9:  k2 ^= (ull)tail[8];
+	             k2 *= c2; k2 = hash_rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+	             /* fallthrough */
+	    case 8:  k1 ^= (ull)tail[7] << 56;  /* fallthrough */
+	    case 7:  k1 ^= (ull)tail[6] << 48;  /* fallthrough */
+	    case 6:  k1 ^= (ull)tail[5] << 40;  /* fallthrough */
+	    case 5:  k1 ^= (ull)tail[4] << 32;  /* fallthrough */
+	    case 4:  k1 ^= (ull)tail[3] << 24;  /* fallthrough */
+	    case 3:  k1 ^= (ull)tail[2] << 16;  /* fallthrough */
+	    case 2:  k1 ^= (ull)tail[1] << 8;   /* fallthrough */
+	    case 1:  k1 ^= (ull)tail[0];
+	             k1 *= c1; k1 = hash_rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+	    }
+
+	    h1 ^= (ull)len; h2 ^= (ull)len;
+	    h1 += h2; h2 += h1;
+	    h1 = hash_fmix64(h1); h2 = hash_fmix64(h2);
+	    h1 += h2; h2 += h1;
+
+	    return (Hash128){ h1, h2 };
+	}
+
+	#define CACHE_MAGIC   0x31484341434f4141ULL // "AAOCACH1"
+	#define CACHE_SLOTS   4096
+	#define CACHE_PROBES  8
+
+	typedef struct {
+	    ull build_id;
+	    Hash128 key;
+	    uint day;
+	    uint used;
+	    ll answers[2];
+	} CacheEntry;
+
+	typedef struct {
+	    ull magic;
+	    ull slots;
+	    CacheEntry entries[CACHE_SLOTS];
+	} CacheStore;
+
+	typedef struct {
+	    CacheStore *store;
+	    int fd;          // open store file, held for flock
+	    ull build_id;
+	    Hash128 key;
+	    uint day;
+	} Cache;
+
+	// Identify the running binary by hashing its own image; 0 if unreadable
+	static ull cache_build_id(void) {
+	    int fd = open("/proc/self/exe", O_RDONLY);
+	    if (fd < 0) return 0;
+
+	    struct stat st;
+	    ull id = 0;
+	    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+	        void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	        if (p != MAP_FAILED) {
+	            id = hash128(p, (size_t)st.st_size, 0).lo | 1;
+	            munmap(p, (size_t)st.st_size);
+	        }
+	    }
+	    close(fd);
+
+	    return id;
+	}
+
+	static CacheStore *cache_map_store(int *fd_out) {
+	    char base[PATH_MAX], dir[PATH_MAX + 16], path[PATH_MAX + 32];
+	    const char *xdg = getenv("XDG_CACHE_HOME");
+	    const char *home = getenv("HOME");
+
+	    if (xdg && *xdg) snprintf(base, sizeof(base), "%s", xdg);
+	    else if (home && *home) snprintf(base, sizeof(base), "%s/.cache", home);
+	    else return NULL;
+
+	    snprintf(dir, sizeof(dir), "%s/aoc2025", base);
+	    mkdir(base, 0755);
+	    mkdir(dir, 0755);
+	    snprintf(path, sizeof(path), "%s/results.bin", dir);
+
+	    int fd = open(path, O_RDWR | O_CREAT, 0644);
+	    if (fd < 0) return NULL;
+
+	    struct stat st;
+	    if (fstat(fd, &st) < 0 || ((size_t)st.st_size != sizeof(CacheStore) && ftruncate(fd, sizeof(CacheStore)) < 0)) {
+	        close(fd);
+	        return NULL;
+	    }
+
+	    CacheStore *s = mmap(NULL, sizeof(CacheStore), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	    if (s == MAP_FAILED) {
+	        close(fd);
+	        return NULL;
+	    }
+
+	    // Fresh or foreign file: reset it
+	    flock(fd, LOCK_EX);
+	    if (s->magic != CACHE_MAGIC || s->slots != CACHE_SLOTS) {
+	        memset(s, 0, sizeof(CacheStore));
+	        s->magic = CACHE_MAGIC;
+	        s->slots = CACHE_SLOTS;
+	    }
+	    flock(fd, LOCK_UN);
+
+	    *fd_out = fd;
+	    return s;
+	}
+
+	// Returns a disabled cache (store == NULL) unless AOC_CACHE is set, the
+	// input bytes are available up front and the binary can be identified
+	static Cache cache_open(uint day, Span input) {
+	    Cache c = { .day = day };
+	    const char *env = getenv("AOC_CACHE");
+	    if (!env || !*env || strcmp(env, "0") == 0 || !input.data) return c;
+
+	    // Without a build id a rebuilt solver could match stale entries
+	    c.build_id = cache_build_id();
+	    if (c.build_id == 0) return c;
+
+	    c.store = cache_map_store(&c.fd);
+	    if (!c.store) return c;
+
+	    c.key = hash128(input.data, input.len, day);
+
+	    return c;
+	}
+
+	static inline bool cache_entry_matches(const Cache *c, const CacheEntry *e) {
+	    return e->used && e->day == c->day && e->build_id == c->build_id
+	        && e->key.lo == c->key.lo && e->key.hi == c->key.hi;
+	}
+
+	static bool cache_lookup(const Cache *c, ll answers[2]) {
+	    if (!c->store) return false;
+
+	    bool found = false;
+	    flock(c->fd, LOCK_SH);
+	    for (uint i = 0; i < CACHE_PROBES; ++i) {
+	        const CacheEntry *e = &c->store->entries[(c->key.lo + i) % CACHE_SLOTS];
+	        if (cache_entry_matches(c, e)) {
+	            answers[0] = e->answers[0];
+	            answers[1] = e->answers[1];
+	            found = true;
+	            break;
+	        }
+	    }
+	    flock(c->fd, LOCK_UN);
+	    return found;
+	}
+
+	static void cache_store(const Cache *c, const ll answers[2]) {
+	    if (!c->store) return;
+
+	    // Readers hold LOCK_SH, so no one sees a half-rewritten entry
+	    flock(c->fd, LOCK_EX);
+
+	    // Prefer an empty or stale (other build) slot, else evict the home slot
+	    CacheEntry *victim = &c->store->entries[c->key.lo % CACHE_SLOTS];
+	    for (uint i = 0; i < CACHE_PROBES; ++i) {
+	        CacheEntry *e = &c->store->entries[(c->key.lo + i) % CACHE_SLOTS];
+	        if (!e->used || e->build_id != c->build_id || cache_entry_matches(c, e)) {
+	            victim = e;
+	            break;
+	        }
+	    }
+
+	    victim->build_id = c->build_id;
+	    victim->key = c->key;
+	    victim->day = c->day;
+	    victim->answers[0] = answers[0];
+	    victim->answers[1] = answers[1];
+	    victim->used = 1;
+	    flock(c->fd, LOCK_UN);
+	}
+
+	static void cache_close(Cache *c) {
+	    if (c->store) {
+	        munmap(c->store, sizeof(CacheStore));
+	        close(c->fd);
+	    }
+	    c->store = NULL;
+	    c->fd = -1;
+	}
+
+	#endif // CACHE_IMPLEMENTATION
+
+	#ifdef STREAM_IMPLEMENTATION
+
+	#ifndef MMAP_IMPLEMENTATION
+	#error "STREAM_IMPLEMENTATION requires MMAP_IMPLEMENTATION"
+	#endif
+
+	#include <pthread.h>
+
+	// Double-buffered reader for pipes: a background thread read()s into one
+	// buffer while the solver walks lines in the other. Lines that straddle
+	// the two buffers are stitched into a carry buffer.
+
+	#define STREAM_BUF_SIZE (4u << 20)
+
+	typedef struct {
+	    int fd;
+	    pthread_t thread;
+	    pthread_mutex_t mu;
+	    pthread_cond_t cv;
+
+	    char *buf[2];
+	    size_t len[2];
+	    bool full[2];
+	    bool eof;      // producer hit end of file (after the last full buffer)
+	    bool stop;     // consumer closed the stream early
+	    int err;       // errno of a failed read(), 0 otherwise
+
+	    int cur;       // buffer the consumer is walking, -1 before the first one
+	    Span rest;     // unconsumed bytes of buf[cur]
+	    Bytes carry;   // line split across buffers
+	} Stream;
+
+	static void *stream_producer(void *arg) {
+	    Stream *s = arg;
+
+	    // Only a blocking read() may be cancelled, never a wait holding the lock
+	    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+
+	    for (int i = 0;; i ^= 1) {
+	        pthread_mutex_lock(&s->mu);
+	        while (s->full[i] && !s->stop) pthread_cond_wait(&s->cv, &s->mu);
+	        bool stop = s->stop;
+	        pthread_mutex_unlock(&s->mu);
+	        if (stop) return NULL;
+
+	        // Fill outside the lock; the consumer never touches an empty buffer
+	        size_t n = 0;
+	        int err = 0;
+	        while (n < STREAM_BUF_SIZE) {
+	            pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+	            ssize_t r = read(s->fd, s->buf[i] + n, STREAM_BUF_SIZE - n);
+	            pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+	            if (r < 0) { err = errno; break; }
+	            if (r == 0) break;
+	            n += (size_t)r;
+	        }
+
+	        pthread_mutex_lock(&s->mu);
+	        s->len[i] = n;
+	        s->full[i] = n > 0;
+	        if (n < STREAM_BUF_SIZE) {
+	            s->eof = true;
+	            s->err = err;
+	        }
+	        pthread_cond_broadcast(&s->cv);
+	        bool done = s->eof;
+	        pthread_mutex_unlock(&s->mu);
+
+	        if (done) return NULL;
+	    }
+	}
+
+	static Stream *stream_open_fd(int fd) {
+	    Stream *s = xmalloc(sizeof(Stream));
+	    memset(s, 0, sizeof(Stream));
+
+	    s->fd = fd;
+	    s->cur = -1;
+	    s->buf[0] = xmalloc(STREAM_BUF_SIZE);
+	    s->buf[1] = xmalloc(STREAM_BUF_SIZE);
+	    pthread_mutex_init(&s->mu, NULL);
+	    pthread_cond_init(&s->cv, NULL);
+
+	    if (pthread_create(&s->thread, NULL, stream_producer, s) != 0) die("pthread_create failed");
+
+	    return s;
+	}
+
+	// Release buf[cur] back to the producer and wait for the next one.
+	// Returns false at end of input.
+	static bool stream_advance(Stream *s) {
+	    int next = s->cur < 0 ? 0 : s->cur ^ 1;
+
+	    pthread_mutex_lock(&s->mu);
+	    if (s->cur >= 0) {
+	        s->full[s->cur] = false;
+	        pthread_cond_broadcast(&s->cv);
+	    }
+	    while (!s->full[next] && !s->eof) pthread_cond_wait(&s->cv, &s->mu);
+	    bool ok = s->full[next];
+	    int err = s->err;
+	    pthread_mutex_unlock(&s->mu);
+
+	    if (!ok && err) {
+	        errno = err;
+	        die("read failed");
+	    }
+
+	    s->cur = next;
+	    s->rest = ok ? (Span){ s->buf[next], s->len[next] } : (Span){ NULL, 0 };
+	    return ok;
+	}
+
+	// Same contract as span_next_line: *line stays valid until the next call
+	static bool stream_next_line(Stream *s, Span *line) {
+	    s->carry.count = 0;
+
+	    for (;;) {
+	        if (s->rest.len == 0 && !stream_advance(s)) break;
+
+	        const char *nl = memchr(s->rest.data, '\n', s->rest.len);
+	        if (nl && s->carry.count == 0) return span_next_line(&s->rest, line);
+
+	        size_t n = nl ? (size_t)(nl - s->rest.data) + 1 : s->rest.len;
+	        da_append_many(&s->carry, s->rest.data, n);
+	        s->rest.data += n;
+	        s->rest.len -= n;
+	        if (nl) break;
+	    }
+
+	    if (s->carry.count == 0) return false;
+
+	    Span whole = { s->carry.items, s->carry.count };
+	    return span_next_line(&whole, line);
+	}
+
+	static void stream_close(Stream *s) {
+	    // Wake the producer if the consumer stopped early; cancel only reaches
+	    // it inside a read() that might otherwise block forever
+	    pthread_mutex_lock(&s->mu);
+	    s->stop = true;
+	    bool running = !s->eof;
+	    pthread_cond_broadcast(&s->cv);
+	    pthread_mutex_unlock(&s->mu);
+
+	    if (running) pthread_cancel(s->thread);
+	    pthread_join(s->thread, NULL);
+	    pthread_mutex_destroy(&s->mu);
+	    pthread_cond_destroy(&s->cv);
+
+	    free(s->buf[0]);
+	    free(s->buf[1]);
+	    da_free(&s->carry);
+	    free(s);
+	}
+
+	// Line source over either an mmapped regular file or a streamed pipe
+	typedef struct {
+	    Span map;       // whole input when mapped; { NULL, 0 } when streaming
+	    Span rest;
+	    Stream *stream;
+	} LineReader;
+
+	static LineReader reader_open_input_or_die(int argc, char **argv) {
+	    LineReader r = {0};
+
+	    struct stat st;
+	    if (argc >= 2 && stat(argv[1], &st) == 0 && !S_ISREG(st.st_mode)) {
+	        int fd = open(argv[1], O_RDONLY);
+	        if (fd < 0) die("Error opening input file");
+	        r.stream = stream_open_fd(fd);
+	        return r;
+	    }
+
+	    r.map = map_input_or_die(argc, argv);
+	    r.rest = r.map;
+	    return r;
+	}
+
+	static inline bool reader_next_line(LineReader *r, Span *line) {
+	    return r->stream ? stream_next_line(r->stream, line) : span_next_line(&r->rest, line);
+	}
+
+	static void reader_close(LineReader *r) {
+	    if (r->stream) {
+	        int fd = r->stream->fd;
+	        stream_close(r->stream);
+	        close(fd);
+	    } else {
+	        unmap_input(r->map);
+	    }
+	    *r = (LineReader){0};
+	}
+
+	#endif // STREAM_IMPLEMENTATION
+
+	#ifdef PARALLEL_IMPLEMENTATION
+
+	#include <pthread.h>
+	#include <unistd.h>
+
+	// Worker count: AOC_THREADS if set, otherwise the online CPU count
+	static int parallel_threads(void) {
+	    const char *env = getenv("AOC_THREADS");
+	    long n = (env && *env) ? strtol(env, NULL, 10) : sysconf(_SC_NPROCESSORS_ONLN);
+	    if (n < 1) n = 1;
+	    if (n > 256) n = 256;
+	    return (int)n;
+	}
+
+	// Run fn on n argument blocks laid out `stride` bytes apart; block 0 runs
+	// on the calling thread
+	static void parallel_run(int n, void *(*fn)(void *), void *args, size_t stride) {
+	    pthread_t tids[256];
+	    if (n > 256) n = 256;
+
+	    for (int i = 1; i < n; ++i) {
+	        if (pthread_create(&tids[i], NULL, fn, (char *)args + (size_t)i * stride) != 0) die("pthread_create failed");
+	    }
+	    if (n > 0) fn(args);
+	    for (int i = 1; i < n; ++i) pthread_join(tids[i], NULL);
+	}
+
+	// Cut `input` into at most n pieces of roughly equal size, each ending on
+	// a line boundary. Returns the number of non-empty pieces written.
+	static int span_split_lines(Span input, int n, Span *out) {
+	    int k = 0;
+	    const char *p = input.data, *end = input.data + input.len;
+
+	    for (int i = 0; i < n && p < end; ++i) {
+	        const char *cut = (i == n - 1) ? end : input.data + input.len / (size_t)n * (size_t)(i + 1);
+	        if (cut < p) cut = p;
+	        if (cut < end) {
+	            const char *nl = memchr(cut, '\n', (size_t)(end - cut));
+	            cut = nl ? nl + 1 : end;
+	        }
+	        if (cut > p) out[k++] = (Span){ p, (size_t)(cut - p) };
+	        p = cut;
+	    }
+
+	    return k;
+	}
+
+	#endif // PARALLEL_IMPLEMENTATION
 #endif // NOB_H